@@ -0,0 +1,196 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "misc.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace Stockfish {
+
+namespace {
+
+  // json_score() converts a Value to a JSON object, {"cp":x} or {"mate":y}
+  // with the same meaning as in the UCI "score" field.
+
+  string json_score(Value v) {
+
+    string s = UCI::value(v);
+    size_t sp = s.find(' ');
+    return "{\"" + s.substr(0, sp) + "\":" + s.substr(sp + 1) + "}";
+  }
+
+  // parse_line() splits a line of the input file, a FEN optionally followed
+  // by "moves" and a move list, like the arguments of "position fen".
+
+  void parse_line(const string& line, string& fen, vector<string>& moves) {
+
+    istringstream is(line);
+    string token;
+
+    while (is >> token && token != "moves")
+        fen += token + " ";
+
+    while (is >> token)
+        moves.push_back(token);
+  }
+
+} // namespace
+
+
+/// analyse() is called when the engine receives the "analyse" command:
+///
+/// analyse <file> depth|nodes|movetime <n> [jobs <j>] [sharedtt]
+///
+/// Every non-empty line of the file is a FEN, optionally followed by "moves"
+/// and a move list. The positions are searched by j independent engines of one
+/// thread each, so that many positions are analysed at once rather than one
+/// position with many threads. Every engine has its own histories, and its own
+/// share of the hash unless 'sharedtt' is given, in which case all the engines
+/// search in the hash of the calling one, and the whole batch is a single
+/// search for its aging. A JSON object is printed for each position as soon as
+/// it is done, so the output is in completion order and the "index" field
+/// gives the line of the position in the file.
+
+void analyse(Engine& engine, istream& args) {
+
+  string token, fenFile, limitType;
+  int64_t limit = 0;
+  size_t jobs = 1;
+  bool sharedTT = false;
+
+  args >> fenFile >> limitType >> limit;
+
+  while (args >> token)
+      if (token == "jobs")
+          args >> jobs;
+      else if (token == "sharedtt")
+          sharedTT = true;
+
+  if (   limit <= 0
+      || (limitType != "depth" && limitType != "nodes" && limitType != "movetime"))
+  {
+      sync_cout << "Usage: analyse <file> depth|nodes|movetime <n> [jobs <j>] [sharedtt]" << sync_endl;
+      return;
+  }
+
+  ifstream file(fenFile);
+  if (!file.is_open())
+  {
+      sync_cout << "Unable to open file " << fenFile << sync_endl;
+      return;
+  }
+
+  vector<string> lines;
+  string line;
+  while (getline(file, line))
+      if (line.find_first_not_of(" \t\r") != string::npos)
+          lines.push_back(line);
+
+  jobs = std::clamp(jobs, size_t(1), std::max(lines.size(), size_t(1)));
+
+  Search::LimitsType limits;
+  if (limitType == "depth")
+      limits.depth = int(limit);
+  else if (limitType == "nodes")
+      limits.nodes = limit;
+  else
+      limits.movetime = limit;
+
+  // Without sharing, the hash of the calling engine is split among the jobs
+  size_t hashMB = std::max(size_t(engine.options["Hash"]) / jobs, size_t(1));
+  atomic<size_t> next(0);
+  atomic<uint64_t> totalNodes(0);
+  vector<thread> workers;
+
+  engine.wait_for_search_finished();
+  TimePoint elapsed = now();
+
+  // The workers do not age a shared hash, the whole batch is one new search
+  if (sharedTT)
+      engine.tt.new_search();
+
+  for (size_t j = 0; j < jobs; ++j)
+      workers.emplace_back([&] {
+
+          // The engine is built in the worker thread, so that on a first-touch
+          // system its memory is allocated close to where it is used.
+          Engine worker(sharedTT ? &engine.tt : nullptr);
+          worker.onOutput = nullptr;
+          if (!sharedTT)
+              worker.set_option("Hash", std::to_string(hashMB));
+
+          for (size_t idx = next++; idx < lines.size(); idx = next++)
+          {
+              string fen;
+              vector<string> moves;
+              parse_line(lines[idx], fen, moves);
+
+              stringstream ss;
+              ss << "{\"index\":" << idx;
+
+              if (!worker.set_position(fen, moves))
+              {
+                  ss << ",\"error\":\"illegal move\"}";
+                  sync_cout << ss.str() << sync_endl;
+                  continue;
+              }
+
+              TimePoint start = now();
+              Engine::Result r = worker.search(limits);
+              totalNodes += r.nodes;
+
+              ss << ",\"fen\":\"" << worker.position().fen() << "\""
+                 << ",\"bestmove\":\"" << UCI::move(r.bestMove) << "\""
+                 << ",\"score\":" << json_score(r.score)
+                 << ",\"depth\":" << r.depth
+                 << ",\"nodes\":" << r.nodes
+                 << ",\"time\":" << now() - start
+                 << ",\"pv\":[";
+
+              for (size_t i = 0; i < r.pv.size() && r.pv[i] != MOVE_NONE; ++i)
+                  ss << (i ? ",\"" : "\"") << UCI::move(r.pv[i]) << "\"";
+
+              ss << "]}";
+              sync_cout << ss.str() << sync_endl;
+          }
+      });
+
+  for (thread& th : workers)
+      th.join();
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  cerr << "\n==========================="
+       << "\nPositions       : " << lines.size()
+       << "\nJobs            : " << jobs
+       << "\nTotal time (ms) : " << elapsed
+       << "\nNodes searched  : " << totalNodes
+       << "\nNodes/second    : " << 1000 * totalNodes / elapsed << endl;
+}
+
+} // namespace Stockfish
@@ -0,0 +1,781 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "bitbase.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "misc.h"
+#include "position.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace Stockfish {
+
+int Bitbases::MaxCardinality;
+
+namespace {
+
+  constexpr int MaxPieces = 8;
+  constexpr uint32_t Magic = 0x42425851; // "QXBB"
+  constexpr uint32_t Version = 1;
+  constexpr size_t BlockSize = 1024;     // Entries, 4 per byte
+  constexpr uint32_t Uniform = 1u << 31;
+
+  // The results of the entries, for the side to move. Only the first three
+  // are written to the files, the others are used by the generator.
+  enum Result : uint8_t { LOSS, DRAW, WIN, INVALID, UNKNOWN };
+
+  // The file starts with a header, then a descriptor for every block of
+  // BlockSize entries, then the blocks themselves with 2 bits per entry.
+  // A descriptor is either Uniform | result, when all the entries of its
+  // block have the same result, or the offset of its block. The invalid
+  // positions take the most common result of their block, so that most
+  // blocks are uniform. The file is stored in host byte order.
+  struct Header {
+    uint32_t magic, version;
+    char code[16];
+    uint64_t entries;
+    uint32_t blockSize, blocks;
+  };
+
+  static_assert(sizeof(Header) == 40, "Unexpected Header size");
+
+
+  // SquareIndex maps the squares a piece can stand on to consecutive indices.
+  // The strong side is white, and the position is mirrored so that its king
+  // is on the files D and E. Advisors and bishops can only stand on a few
+  // squares of their side, and pawns never go back.
+
+  struct SquareTables {
+
+    SquareTables() {
+
+      constexpr Square Advisors[] = { SQ_D0, SQ_F0, SQ_E1, SQ_D2, SQ_F2 };
+      constexpr Square Bishops[]  = { SQ_C0, SQ_G0, SQ_A2, SQ_E2, SQ_I2, SQ_C4, SQ_G4 };
+
+      Bitboard b[COLOR_NB][PIECE_TYPE_NB] = {};
+
+      for (Square s : Advisors)
+          b[WHITE][ADVISOR] |= s, b[BLACK][ADVISOR] |= flip_rank(s);
+
+      for (Square s : Bishops)
+          b[WHITE][BISHOP] |= s, b[BLACK][BISHOP] |= flip_rank(s);
+
+      b[WHITE][KING] = Palace & HalfBB[WHITE] & (FileDBB | FileEBB);
+      b[BLACK][KING] = Palace & HalfBB[BLACK];
+      b[WHITE][PAWN] = PawnBB[WHITE];
+      b[BLACK][PAWN] = PawnBB[BLACK];
+
+      for (Color c : { WHITE, BLACK })
+          for (PieceType pt : { PAWN, ADVISOR, BISHOP, KING })
+          {
+              std::fill_n(index[c][pt], SQUARE_NB, -1);
+              count[c][pt] = 0;
+
+              for (Bitboard bb = b[c][pt]; bb; ++count[c][pt])
+              {
+                  Square s = pop_lsb(bb);
+                  index[c][pt][s] = int8_t(count[c][pt]);
+                  square[c][pt][count[c][pt]] = s;
+              }
+          }
+    }
+
+    int8_t index[COLOR_NB][PIECE_TYPE_NB][SQUARE_NB];
+    Square square[COLOR_NB][PIECE_TYPE_NB][SQUARE_NB];
+    int count[COLOR_NB][PIECE_TYPE_NB];
+  };
+
+  const SquareTables Squares;
+
+
+  // Board is a position reduced to its pieces and side to move
+
+  struct Board {
+    Color stm;
+    int n;
+    Piece pc[MaxPieces];
+    Square sq[MaxPieces];
+  };
+
+
+  // side_code() returns the part of an endgame code for the pieces of one side
+
+  string side_code(const int cnt[]) {
+    return "K" + string(cnt[PAWN], 'P') + string(cnt[ADVISOR], 'A') + string(cnt[BISHOP], 'B');
+  }
+
+  // canonical() returns the code of an endgame, the side with more pawns, then
+  // with more pieces, first. It tells if the black side of cnt comes first.
+
+  string canonical(const int cnt[COLOR_NB][PIECE_TYPE_NB], bool& swapped) {
+
+    string s[] = { side_code(cnt[WHITE]), side_code(cnt[BLACK]) };
+
+    swapped = std::make_tuple(cnt[BLACK][PAWN], s[BLACK].length(), s[BLACK])
+            > std::make_tuple(cnt[WHITE][PAWN], s[WHITE].length(), s[WHITE]);
+
+    return swapped ? s[BLACK] + s[WHITE] : s[WHITE] + s[BLACK];
+  }
+
+
+  // Layout maps the positions of an endgame to the indices of its table. The
+  // pieces are the slots of a mixed radix number, the side to move being the
+  // most significant digit, then the pawns, advisors, bishops and the kings.
+  // Pieces of the same kind are sorted by square.
+
+  struct Layout {
+
+    bool set(const string& code);
+    uint64_t index(const Board& b, Color strong) const;
+    Color decode(uint64_t idx, Square sq[]) const;
+    bool same_kind(int k) const { return k && type[k] == type[k - 1] && color[k] == color[k - 1]; }
+
+    string code;
+    int n = 0;
+    int cnt[COLOR_NB][PIECE_TYPE_NB] = {};
+    Color color[MaxPieces];  // WHITE for the strong side
+    PieceType type[MaxPieces];
+    uint64_t size = 0;
+  };
+
+
+  // Layout::set() parses an endgame code like "KPKAB", the pieces of the strong
+  // side first. Only kings, pawns, advisors and bishops are supported.
+
+  bool Layout::set(const string& c) {
+
+    const string PieceToChar(" RACPNBK");
+    size_t weak = c.find('K', 1);
+
+    if (c.length() > MaxPieces || c.empty() || c[0] != 'K' || weak == string::npos)
+        return false;
+
+    std::memset(cnt, 0, sizeof(cnt));
+
+    for (size_t i = 0; i < c.length(); ++i)
+    {
+        size_t pt = PieceToChar.find(c[i]);
+        if (pt != PAWN && pt != ADVISOR && pt != BISHOP && pt != KING)
+            return false;
+
+        ++cnt[i < weak ? WHITE : BLACK][pt];
+    }
+
+    if (   cnt[WHITE][KING] != 1 || cnt[BLACK][KING] != 1
+        || std::max(cnt[WHITE][PAWN], cnt[BLACK][PAWN]) > 5
+        || std::max({ cnt[WHITE][ADVISOR], cnt[BLACK][ADVISOR], cnt[WHITE][BISHOP], cnt[BLACK][BISHOP] }) > 2)
+        return false;
+
+    code = c;
+    n = 0;
+    size = COLOR_NB;
+
+    for (PieceType pt : { PAWN, ADVISOR, BISHOP, KING })
+        for (Color side : { WHITE, BLACK })
+            for (int i = 0; i < cnt[side][pt]; ++i)
+            {
+                color[n] = side;
+                type[n++] = pt;
+                size *= Squares.count[side][pt];
+            }
+
+    return true;
+  }
+
+
+  // Layout::index() returns the index of a board, or size if one of its pieces
+  // stands on a square out of the table, which a legal position never does.
+
+  uint64_t Layout::index(const Board& b, Color strong) const {
+
+    Square sq[MaxPieces];
+    bool used[MaxPieces] = {};
+    bool mirror = false;
+
+    for (int k = 0; k < n; ++k)
+    {
+        Piece pc = make_piece(color[k] == WHITE ? strong : ~strong, type[k]);
+        int i = 0;
+
+        while (used[i] || b.pc[i] != pc)
+            ++i;
+
+        assert(i < b.n);
+
+        used[i] = true;
+        sq[k] = strong == WHITE ? b.sq[i] : flip_rank(b.sq[i]);
+
+        if (type[k] == KING && color[k] == WHITE)
+            mirror = file_of(sq[k]) > FILE_E;
+    }
+
+    uint64_t idx = b.stm == strong ? WHITE : BLACK;
+
+    for (int k = 0; k < n; ++k)
+    {
+        if (mirror)
+            sq[k] = flip_file(sq[k]);
+
+        for (int j = k; same_kind(j) && sq[j - 1] > sq[j]; --j)
+            std::swap(sq[j - 1], sq[j]);
+    }
+
+    for (int k = 0; k < n; ++k)
+    {
+        int i = Squares.index[color[k]][type[k]][sq[k]];
+        if (i < 0)
+            return size;
+
+        idx = idx * Squares.count[color[k]][type[k]] + i;
+    }
+
+    return idx;
+  }
+
+
+  // Layout::decode() sets the squares of the pieces of an index and returns
+  // its side to move, white being the strong side.
+
+  Color Layout::decode(uint64_t idx, Square sq[]) const {
+
+    for (int k = n - 1; k >= 0; --k)
+    {
+        int count = Squares.count[color[k]][type[k]];
+        sq[k] = Squares.square[color[k]][type[k]][idx % count];
+        idx /= count;
+    }
+
+    return Color(idx);
+  }
+
+
+  // Table is a memory mapped bitbase
+
+  struct Table {
+
+    bool open(const string& fname, const string& code);
+    Result result(uint64_t idx) const;
+
+    Layout layout;
+    MappedFile file;
+    const uint32_t* blocks;
+    const uint8_t* data;
+  };
+
+  vector<unique_ptr<Table>> Tables;
+  unordered_map<Key, pair<const Table*, Color>> TableMap;
+
+
+  // Table::open() maps a bitbase file and checks that it is consistent
+
+  bool Table::open(const string& fname, const string& code) {
+
+    if (!layout.set(code) || !file.open(fname) || file.size() < sizeof(Header))
+        return false;
+
+    const Header* h = static_cast<const Header*>(file.data());
+    uint64_t nBlocks = (layout.size + BlockSize - 1) / BlockSize;
+    size_t dataOffset = sizeof(Header) + nBlocks * sizeof(uint32_t);
+
+    if (   h->magic != Magic
+        || h->version != Version
+        || string(h->code, strnlen(h->code, sizeof(h->code))) != code
+        || h->entries != layout.size
+        || h->blockSize != BlockSize
+        || h->blocks != nBlocks
+        || file.size() < dataOffset)
+        return false;
+
+    blocks = reinterpret_cast<const uint32_t*>(h + 1);
+    data = static_cast<const uint8_t*>(file.data()) + dataOffset;
+
+    for (uint64_t b = 0; b < nBlocks; ++b)
+        if (   (blocks[b] & Uniform) ? (blocks[b] & ~Uniform) > WIN
+                                     : dataOffset + blocks[b] + BlockSize / 4 > file.size())
+            return false;
+
+    return true;
+  }
+
+
+  Result Table::result(uint64_t idx) const {
+
+    uint32_t d = blocks[idx / BlockSize];
+
+    if (d & Uniform)
+        return Result(d & 3);
+
+    idx %= BlockSize;
+    return Result((data[d + idx / 4] >> (2 * (idx % 4))) & 3);
+  }
+
+
+  // Generator builds the bitbases by retrograde analysis. All the positions
+  // are classified again and again until nothing changes: a position is won
+  // if a move leads to a lost one, and lost if it has no legal moves, in
+  // xiangqi stalemate is a loss, or if all its moves lead to won ones. The
+  // positions left are drawn. The captures lead to smaller endgames, which
+  // are generated first.
+
+  class Generator {
+
+  public:
+    struct Entry {
+      Layout layout;
+      vector<Result> results;
+      struct { const Entry* entry; Color strong; } sub[MaxPieces];
+      uint64_t count[UNKNOWN] = {};
+    };
+
+    explicit Generator(size_t j) : jobs(j) {}
+    const Entry& generate(const string& code);
+    const map<string, unique_ptr<Entry>>& entries() const { return tables; }
+
+  private:
+    Result classify(const Entry& e, uint64_t idx, const atomic<Result>* results) const;
+
+    size_t jobs;
+    map<string, unique_ptr<Entry>> tables;
+  };
+
+
+  // Generator::generate() returns the entry of a canonical endgame code,
+  // generating it and its smaller endgames if not done yet.
+
+  const Generator::Entry& Generator::generate(const string& code) {
+
+    if (auto it = tables.find(code); it != tables.end())
+        return *it->second;
+
+    auto e = make_unique<Entry>();
+    Layout& l = e->layout;
+    bool swapped;
+
+    l.set(code);
+
+    // The smaller endgames, one for each piece that can be captured
+    for (int k = 0; k < l.n; ++k)
+        if (l.type[k] != KING)
+        {
+            int cnt[COLOR_NB][PIECE_TYPE_NB];
+            std::memcpy(cnt, l.cnt, sizeof(cnt));
+            --cnt[l.color[k]][l.type[k]];
+
+            e->sub[k].entry = &generate(canonical(cnt, swapped));
+            e->sub[k].strong = swapped ? BLACK : WHITE;
+        }
+
+    unique_ptr<atomic<Result>[]> results(new atomic<Result>[l.size]);
+
+    for (uint64_t idx = 0; idx < l.size; ++idx)
+        results[idx].store(UNKNOWN, memory_order_relaxed);
+
+    atomic<bool> changed(true);
+
+    while (changed)
+    {
+        atomic<uint64_t> next(0);
+        vector<thread> workers;
+        changed = false;
+
+        for (size_t j = 0; j < jobs; ++j)
+            workers.emplace_back([&] {
+                for (uint64_t begin = next.fetch_add(4096); begin < l.size; begin = next.fetch_add(4096))
+                    for (uint64_t idx = begin; idx < std::min(begin + 4096, l.size); ++idx)
+                        if (results[idx].load(memory_order_relaxed) == UNKNOWN)
+                        {
+                            Result r = classify(*e, idx, results.get());
+                            if (r != UNKNOWN)
+                            {
+                                results[idx].store(r, memory_order_relaxed);
+                                changed.store(true, memory_order_relaxed);
+                            }
+                        }
+            });
+
+        for (thread& th : workers)
+            th.join();
+    }
+
+    e->results.resize(l.size);
+
+    for (uint64_t idx = 0; idx < l.size; ++idx)
+    {
+        Result r = results[idx].load(memory_order_relaxed);
+        e->results[idx] = r == UNKNOWN ? DRAW : r;
+
+        if (e->results[idx] != INVALID)
+            ++e->count[e->results[idx]];
+    }
+
+    return *(tables[code] = std::move(e));
+  }
+
+
+  // Generator::classify() returns the result of a position, UNKNOWN if not yet
+  // known. The results of the smaller endgames are all known.
+
+  Result Generator::classify(const Entry& e, uint64_t idx, const atomic<Result>* results) const {
+
+    const Layout& l = e.layout;
+    Square sq[MaxPieces];
+    Color us = l.decode(idx, sq);
+    Bitboard occupied = 0, byColor[COLOR_NB] = {};
+    int ksq[COLOR_NB];
+
+    for (int k = 0; k < l.n; ++k)
+    {
+        if ((occupied & sq[k]) || (l.same_kind(k) && sq[k - 1] > sq[k]))
+            return INVALID;
+
+        occupied |= sq[k];
+        byColor[l.color[k]] |= sq[k];
+
+        if (l.type[k] == KING)
+            ksq[l.color[k]] = k;
+    }
+
+    // Pawns and the facing king are the only attackers of these endgames
+    auto in_check = [&](Color c, const Square* s, Bitboard occ, int captured) {
+
+        Square k1 = s[ksq[c]], k2 = s[ksq[~c]];
+
+        if (file_of(k1) == file_of(k2) && !((between_bb(k1, k2) ^ k2) & occ))
+            return true;
+
+        for (int k = 0; k < l.n; ++k)
+            if (   k != captured && l.color[k] == ~c && l.type[k] == PAWN
+                && (pawn_attacks_bb(~c, s[k]) & k1))
+                return true;
+
+        return false;
+    };
+
+    if (in_check(~us, sq, occupied, -1))
+        return INVALID;
+
+    bool anyMove = false, allWin = true;
+
+    for (int k = 0; k < l.n; ++k)
+    {
+        if (l.color[k] != us)
+            continue;
+
+        Square from = sq[k];
+        Bitboard b =  l.type[k] == KING    ? attacks_bb<KING>(from)
+                    : l.type[k] == ADVISOR ? attacks_bb<ADVISOR>(from)
+                    : l.type[k] == BISHOP  ? attacks_bb<BISHOP>(from, occupied)
+                                           : pawn_attacks_bb(us, from);
+
+        for (b &= ~byColor[us]; b; )
+        {
+            Square to = pop_lsb(b);
+            Square s[MaxPieces];
+            int captured = -1;
+
+            std::copy(sq, sq + l.n, s);
+            s[k] = to;
+
+            if (byColor[~us] & to)
+                captured = int(std::find(sq, sq + l.n, to) - sq);
+
+            if (in_check(us, s, (occupied ^ from) | to, captured))
+                continue;
+
+            Board child;
+            child.stm = ~us;
+            child.n = 0;
+
+            for (int i = 0; i < l.n; ++i)
+                if (i != captured)
+                {
+                    child.pc[child.n] = make_piece(l.color[i], l.type[i]);
+                    child.sq[child.n++] = s[i];
+                }
+
+            Result r;
+            if (captured < 0)
+                r = results[l.index(child, WHITE)].load(memory_order_relaxed);
+            else
+            {
+                const Entry& sub = *e.sub[captured].entry;
+                r = sub.results[sub.layout.index(child, e.sub[captured].strong)];
+            }
+
+            assert(r != INVALID);
+
+            if (r == LOSS)
+                return WIN;
+
+            anyMove = true;
+            allWin &= r == WIN;
+        }
+    }
+
+    return !anyMove || allWin ? LOSS : UNKNOWN;
+  }
+
+
+  // write() writes the bitbase of an entry, see Header. It returns the size
+  // of the file, 0 if it could not be written.
+
+  size_t write(const Generator::Entry& e, const string& fname) {
+
+    uint64_t size = e.layout.size;
+    uint64_t nBlocks = (size + BlockSize - 1) / BlockSize;
+    vector<uint32_t> descriptors(nBlocks);
+    vector<uint8_t> data;
+
+    for (uint64_t b = 0; b < nBlocks; ++b)
+    {
+        uint64_t begin = b * BlockSize, end = std::min(begin + BlockSize, size);
+        uint64_t count[INVALID] = {};
+
+        for (uint64_t idx = begin; idx < end; ++idx)
+            if (e.results[idx] != INVALID)
+                ++count[e.results[idx]];
+
+        Result filler = Result(std::max_element(count, count + INVALID) - count);
+
+        if (count[filler] + std::count(e.results.begin() + begin, e.results.begin() + end, INVALID) == end - begin)
+        {
+            descriptors[b] = Uniform | filler;
+            continue;
+        }
+
+        descriptors[b] = uint32_t(data.size());
+        data.resize(data.size() + BlockSize / 4, 0);
+
+        for (uint64_t idx = begin; idx < end; ++idx)
+        {
+            Result r = e.results[idx] != INVALID ? e.results[idx] : filler;
+            data[descriptors[b] + (idx - begin) / 4] |= r << (2 * ((idx - begin) % 4));
+        }
+    }
+
+    Header h = { Magic, Version, {}, size, uint32_t(BlockSize), uint32_t(nBlocks) };
+    std::strncpy(h.code, e.layout.code.c_str(), sizeof(h.code) - 1);
+
+    ofstream out(fname, ios::binary);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    out.write(reinterpret_cast<const char*>(descriptors.data()), nBlocks * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    return out ? sizeof(h) + nBlocks * sizeof(uint32_t) + data.size() : 0;
+  }
+
+} // namespace
+
+
+/// Bitbases::init() maps the bitbases found in a list of directories, separated
+/// by ';' on Windows and by ':' elsewhere, like Stockfish's SyzygyPath. Every
+/// endgame code is tried. It returns the number of bitbases found. It must not
+/// be called during a search.
+
+size_t Bitbases::init(const string& paths) {
+
+  TableMap.clear();
+  Tables.clear();
+  MaxCardinality = 0;
+
+  if (paths.empty() || paths == "<empty>")
+      return 0;
+
+#if defined(_WIN32)
+  constexpr char SepChar = ';';
+#else
+  constexpr char SepChar = ':';
+#endif
+
+  vector<string> dirs;
+  stringstream ss(paths);
+  string dir;
+
+  while (getline(ss, dir, SepChar))
+      if (!dir.empty())
+          dirs.push_back(dir);
+
+  int cnt[COLOR_NB][PIECE_TYPE_NB] = {};
+  bool swapped;
+
+  cnt[WHITE][KING] = cnt[BLACK][KING] = 1;
+
+  for (int i = 0; i < 6 * 3 * 3 * 6 * 3 * 3; ++i)
+  {
+      cnt[WHITE][PAWN] = i % 6, cnt[WHITE][ADVISOR] = i / 6 % 3, cnt[WHITE][BISHOP] = i / 18 % 3;
+      cnt[BLACK][PAWN] = i / 54 % 6, cnt[BLACK][ADVISOR] = i / 324 % 3, cnt[BLACK][BISHOP] = i / 972;
+
+      string code = canonical(cnt, swapped);
+
+      if (swapped || code.length() > MaxPieces || (!cnt[WHITE][PAWN] && !cnt[BLACK][PAWN]))
+          continue;
+
+      for (const string& d : dirs)
+      {
+          auto t = make_unique<Table>();
+          if (!t->open(d + "/" + code + ".bb", code))
+              continue;
+
+          TableMap[Position::material_key(code, WHITE)] = { t.get(), WHITE };
+          TableMap[Position::material_key(code, BLACK)] = { t.get(), BLACK };
+          MaxCardinality = std::max(MaxCardinality, int(code.length()));
+          Tables.push_back(std::move(t));
+          break;
+      }
+  }
+
+  return Tables.size();
+}
+
+
+/// Bitbases::probe() looks up the result of a position in the bitbases. It
+/// returns false if there is no bitbase for its material.
+
+bool Bitbases::probe(const Position& pos, WDLScore& wdl) {
+
+  auto it = TableMap.find(pos.material_key());
+  if (it == TableMap.end())
+      return false;
+
+  const auto& [table, strong] = it->second;
+  Board b;
+  b.stm = pos.side_to_move();
+  b.n = 0;
+
+  for (Bitboard bb = pos.pieces(); bb; ++b.n)
+  {
+      b.sq[b.n] = pop_lsb(bb);
+      b.pc[b.n] = pos.piece_on(b.sq[b.n]);
+  }
+
+  uint64_t idx = table->layout.index(b, strong);
+  if (idx == table->layout.size)
+      return false;
+
+  wdl = WDLScore(table->result(idx) - DRAW);
+  return true;
+}
+
+
+/// tbgen() is called when the engine receives the "tbgen" command:
+///
+/// tbgen [<code> ...] [jobs <j>] [path <dir>]
+///
+/// It generates the bitbases of the given endgames, by default those of a
+/// pawn against up to two defenders, of two pawns and of pawn against pawn,
+/// with j threads (by default the "Threads" option). The smaller endgames
+/// reached by captures are generated too, and all the endgames with a pawn
+/// are written as <code>.bb files to the directory (by default the current
+/// one). The bitbases of the BitbasePath option are loaded again at the end.
+
+void tbgen(Engine& engine, istream& args) {
+
+  string token, path = ".";
+  vector<string> codes;
+  size_t jobs = size_t(engine.options["Threads"]);
+
+  while (args >> token)
+      if (token == "jobs")
+          args >> jobs;
+      else if (token == "path")
+          args >> path;
+      else
+          codes.push_back(token);
+
+  if (codes.empty())
+      codes = { "KPK", "KPKA", "KPKB", "KPKAA", "KPKAB", "KPKBB", "KPPK", "KPKP" };
+
+  for (string& code : codes)
+  {
+      Layout l;
+      bool swapped;
+
+      if (!l.set(code))
+      {
+          sync_cout << "Unsupported endgame " << code
+                    << ", only kings, pawns, advisors and bishops are supported" << sync_endl;
+          return;
+      }
+
+      code = canonical(l.cnt, swapped);
+  }
+
+  // The files may be mapped, unmap them before they are written
+  engine.wait_for_search_finished();
+  Bitbases::init("");
+
+  Generator gen(std::max(jobs, size_t(1)));
+  TimePoint elapsed = now();
+  uint64_t positions = 0;
+  size_t files = 0;
+
+  for (const string& code : codes)
+      gen.generate(code);
+
+  for (const auto& [code, e] : gen.entries())
+  {
+      if (!e->layout.cnt[WHITE][PAWN] && !e->layout.cnt[BLACK][PAWN])
+          continue;
+
+      size_t bytes = write(*e, path + "/" + code + ".bb");
+      if (!bytes)
+      {
+          sync_cout << "Unable to write file " << path + "/" + code + ".bb" << sync_endl;
+          continue;
+      }
+
+      uint64_t n = e->count[WIN] + e->count[DRAW] + e->count[LOSS];
+      positions += n;
+      ++files;
+
+      sync_cout << std::left << std::setw(10) << code
+                << " positions " << std::setw(9) << n
+                << " win "  << std::setw(9) << e->count[WIN]
+                << " draw " << std::setw(9) << e->count[DRAW]
+                << " loss " << std::setw(9) << e->count[LOSS]
+                << " bytes " << bytes << sync_endl;
+  }
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  sync_cout << "\n==========================="
+            << "\nBitbases        : " << files
+            << "\nPositions       : " << positions
+            << "\nTotal time (ms) : " << elapsed << sync_endl;
+
+  engine.load_bitbases(string(engine.options["BitbasePath"]));
+}
+
+} // namespace Stockfish
@@ -0,0 +1,52 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITBASE_H_INCLUDED
+#define BITBASE_H_INCLUDED
+
+#include <string>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+/// Bitbases are win/draw/loss tables of the small endgames made of kings,
+/// pawns, advisors and bishops, like KPKAB. They are built by the "tbgen"
+/// command and memory mapped from the directories of the BitbasePath option.
+/// The results ignore the 60 move rule and the repetition rules.
+
+namespace Bitbases {
+
+enum WDLScore {
+  WDL_LOSS = -1, // Loss for the side to move
+  WDL_DRAW =  0,
+  WDL_WIN  =  1  // Win for the side to move
+};
+
+extern int MaxCardinality;
+
+size_t init(const std::string& paths);
+bool probe(const Position& pos, WDLScore& wdl);
+
+} // namespace Bitbases
+
+} // namespace Stockfish
+
+#endif // #ifndef BITBASE_H_INCLUDED
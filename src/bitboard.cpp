@@ -17,158 +17,63 @@
 */
 
 #include <algorithm>
-#include <bitset>
 
 #include "bitboard.h"
 #include "misc.h"
 #include "magics.h"
-#include <set>
 #include <iostream>
 
 namespace Stockfish {
 
-uint8_t PopCnt16[1 << 16];
-uint8_t SquareDistance[SQUARE_NB][SQUARE_NB];
-
-Bitboard SquareBB[SQUARE_NB];
-Bitboard LineBB[SQUARE_NB][SQUARE_NB];
-Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
-Bitboard PseudoAttacks[PIECE_TYPE_NB][SQUARE_NB];
-Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
-Bitboard PawnAttacksTo[COLOR_NB][SQUARE_NB];
-
-Magic RookMagics[SQUARE_NB];
-Magic CannonMagics[SQUARE_NB];
-Magic BishopMagics[SQUARE_NB];
-Magic KnightMagics[SQUARE_NB];
-Magic KnightToMagics[SQUARE_NB];
-
 namespace {
 
-  Bitboard RookTable    [0x108000];  // To store rook attacks
-  Bitboard CannonTable  [0x108000];  // To store cannon attacks
-  Bitboard BishopTable  [0x228];     // To store bishop attacks
-  Bitboard KnightTable  [0x380];     // To store knight attacks
-  Bitboard KnightToTable[0x3E0];     // To store by knight attacks
-
-  const std::set<Direction> KnightDirections { 2 * SOUTH + WEST, 2 * SOUTH + EAST, SOUTH + 2 * WEST, SOUTH + 2 * EAST,
-                                               NORTH + 2 * WEST, NORTH + 2 * EAST, 2 * NORTH + WEST, 2 * NORTH + EAST };
-  const std::set<Direction> BishopDirections { 2 * NORTH_EAST, 2 * SOUTH_EAST, 2 * SOUTH_WEST, 2 * NORTH_WEST };
-
-
-  template <PieceType pt>
-  void init_magics(Bitboard table[], Magic magics[], const Bitboard magicsInit[]);
-
-  template <PieceType pt>
-  Bitboard lame_leaper_path(Direction d, Square s);
-
-}
-
-/// safe_destination() returns the bitboard of target square for the given step
-/// from the given square. If the step is off the board, returns empty bitboard.
-
-inline Bitboard safe_destination(Square s, int step) {
-    Square to = Square(s + step);
-    return is_ok(to) && distance(s, to) <= 2 ? square_bb(to) : Bitboard(0);
-}
-
-
-/// Bitboards::pretty() returns an ASCII representation of a bitboard suitable
-/// to be printed to standard output. Useful for debugging.
-
-std::string Bitboards::pretty(Bitboard b) {
+  // The tables below are generated at compile time, so that they are in the
+  // read-only data of the binary and cost nothing at startup. The generators
+  // can't use the lookup tables they are building, hence these small helpers.
 
-  std::string s = "+---+---+---+---+---+---+---+---+---+\n";
+  constexpr Bitboard bb(Square s) { return Bitboard(1ULL) << int(s); }
 
-  for (Rank r = RANK_9; r >= RANK_0; --r)
-  {
-      for (File f = FILE_A; f <= FILE_I; ++f)
-          s += b & make_square(f, r) ? "| X " : "|   ";
+  constexpr int abs_diff(int a, int b) { return a > b ? a - b : b - a; }
 
-      s += "| " + std::to_string(r) + "\n+---+---+---+---+---+---+---+---+---+\n";
+  constexpr int square_distance(Square s1, Square s2) {
+    return std::max(abs_diff(file_of(s1), file_of(s2)), abs_diff(rank_of(s1), rank_of(s2)));
   }
-  s += "  a   b   c   d   e   f   g   h   i\n";
-
-  return s;
-}
-
-
-/// Bitboards::init() initializes various bitboard tables. It is called at
-/// startup and relies on global objects to be already zero-initialized.
-
-void Bitboards::init() {
-
-  for (unsigned i = 0; i < (1 << 16); ++i)
-      PopCnt16[i] = uint8_t(std::bitset<16>(i).count());
-
-  for (Square s = SQ_A0; s <= SQ_I9; ++s)
-      SquareBB[s] = (Bitboard(1ULL) << s);
 
-  for (Square s1 = SQ_A0; s1 <= SQ_I9; ++s1)
-      for (Square s2 = SQ_A0; s2 <= SQ_I9; ++s2)
-          SquareDistance[s1][s2] = std::max(distance<File>(s1, s2), distance<Rank>(s1, s2));
+  constexpr Direction KnightDirections[] = { 2 * SOUTH + WEST, 2 * SOUTH + EAST, SOUTH + 2 * WEST, SOUTH + 2 * EAST,
+                                             NORTH + 2 * WEST, NORTH + 2 * EAST, 2 * NORTH + WEST, 2 * NORTH + EAST };
+  constexpr Direction BishopDirections[] = { 2 * NORTH_EAST, 2 * SOUTH_EAST, 2 * SOUTH_WEST, 2 * NORTH_WEST };
 
-  init_magics<     ROOK>(    RookTable,     RookMagics,     RookMagicsInit);
-  init_magics<   CANNON>(  CannonTable,   CannonMagics,     RookMagicsInit);
-  init_magics<   BISHOP>(  BishopTable,   BishopMagics,   BishopMagicsInit);
-  init_magics<   KNIGHT>(  KnightTable,   KnightMagics,   KnightMagicsInit);
-  init_magics<KNIGHT_TO>(KnightToTable, KnightToMagics, KnightToMagicsInit);
-
-  for (Square s1 = SQ_A0; s1 <= SQ_I9; ++s1)
-  {
-      PawnAttacks[WHITE][s1] = pawn_attacks_bb<WHITE>(s1);
-      PawnAttacks[BLACK][s1] = pawn_attacks_bb<BLACK>(s1);
-
-      PawnAttacksTo[WHITE][s1] = pawn_attacks_to_bb<WHITE>(s1);
-      PawnAttacksTo[BLACK][s1] = pawn_attacks_to_bb<BLACK>(s1);
-
-      PseudoAttacks[  ROOK][s1] = attacks_bb<  ROOK>(s1, 0);
-      PseudoAttacks[BISHOP][s1] = attacks_bb<BISHOP>(s1, 0);
-      PseudoAttacks[KNIGHT][s1] = attacks_bb<KNIGHT>(s1, 0);
-
-      // Only generate pseudo attacks in the palace squares for king and advisor
-      if (Palace & s1) {
-          for (int step : { NORTH, SOUTH, WEST, EAST } )
-              PseudoAttacks[KING][s1] |= safe_destination(s1, step);
-          PseudoAttacks[KING][s1] &= Palace;
-
-          for (int step : { NORTH_WEST, NORTH_EAST, SOUTH_WEST, SOUTH_EAST } )
-              PseudoAttacks[ADVISOR][s1] |= safe_destination(s1, step);
-          PseudoAttacks[ADVISOR][s1] &= Palace;
-      }
+  template <PieceType pt>
+  constexpr auto& leaper_directions() {
+    if constexpr (pt == BISHOP)
+      return BishopDirections;
+    else
+      return KnightDirections;
+  }
 
-      for (Square s2 = SQ_A0; s2 <= SQ_I9; ++s2)
-      {
-          if (PseudoAttacks[ROOK][s1] & s2)
-          {
-              LineBB[s1][s2]    = (attacks_bb(ROOK, s1, 0) & attacks_bb(ROOK, s2, 0)) | s1 | s2;
-              BetweenBB[s1][s2] = (attacks_bb(ROOK, s1, square_bb(s2)) & attacks_bb(ROOK, s2, square_bb(s1)));
-          }
 
-          if (PseudoAttacks[KNIGHT][s1] & s2)
-              BetweenBB[s1][s2] |= lame_leaper_path<KNIGHT_TO>(Direction(s2 - s1), s1);
+  /// safe_destination() returns the bitboard of target square for the given step
+  /// from the given square. If the step is off the board, returns empty bitboard.
 
-          BetweenBB[s1][s2] |= s2;
-      }
+  constexpr Bitboard safe_destination(Square s, int step) {
+    Square to = Square(s + step);
+    return is_ok(to) && square_distance(s, to) <= 2 ? bb(to) : Bitboard(0);
   }
-}
-
-namespace {
 
   template <PieceType pt>
-  Bitboard sliding_attack(Square sq, Bitboard occupied) {
+  constexpr Bitboard sliding_attack(Square sq, Bitboard occupied) {
     assert(pt == ROOK || pt == CANNON);
     Bitboard attack = 0;
 
-    for (auto const& d : { NORTH, SOUTH, EAST, WEST } )
+    for (Direction d : { NORTH, SOUTH, EAST, WEST } )
     {
       bool hurdle = false;
-      for (Square s = sq + d; is_ok(s) && distance(s - d, s) == 1; s += d)
+      for (Square s = sq + d; is_ok(s) && square_distance(s - d, s) == 1; s += d)
       {
         if (pt == ROOK || hurdle)
-          attack |= s;
+          attack |= bb(s);
 
-        if (occupied & s)
+        if (occupied & bb(s))
         {
           if (pt == CANNON && !hurdle)
             hurdle = true;
@@ -182,37 +87,30 @@ namespace {
   }
 
   template <PieceType pt>
-  Bitboard lame_leaper_path(Direction d, Square s) {
-    Bitboard b = 0;
+  constexpr Bitboard lame_leaper_path(Direction d, Square s) {
     Square to = s + d;
-    if (!is_ok(to) || distance(s, to) >= 4)
-        return b;
+    if (!is_ok(to) || square_distance(s, to) >= 4)
+        return 0;
 
     // If piece type is by knight attacks, swap the source and destination square
     if (pt == KNIGHT_TO) {
-      std::swap(s, to);
+      Square tmp = s;
+      s = to;
+      to = tmp;
       d = -d;
     }
 
     Direction dr = d > 0 ? NORTH : SOUTH;
-    Direction df = (std::abs(d % NORTH) < NORTH / 2 ? d % NORTH : -(d % NORTH)) < 0 ? WEST : EAST;
+    Direction df = (abs_diff(d % NORTH, 0) < NORTH / 2 ? d % NORTH : -(d % NORTH)) < 0 ? WEST : EAST;
 
-    int diff = std::abs(file_of(to) - file_of(s)) - std::abs(rank_of(to) - rank_of(s));
-    if (diff > 0)
-      s += df;
-    else if (diff < 0)
-      s += dr;
-    else
-      s += df + dr;
-
-    b |= s;
-    return b;
+    int diff = abs_diff(file_of(to), file_of(s)) - abs_diff(rank_of(to), rank_of(s));
+    return bb(diff > 0 ? s + df : diff < 0 ? s + dr : s + df + dr);
   }
 
   template <PieceType pt>
-  Bitboard lame_leaper_path(Square s) {
+  constexpr Bitboard lame_leaper_path(Square s) {
     Bitboard b = 0;
-    for (const auto& d : pt == BISHOP ? BishopDirections : KnightDirections)
+    for (Direction d : leaper_directions<pt>())
       b |= lame_leaper_path<pt>(d, s);
     if (pt == BISHOP)
       b &= HalfBB[rank_of(s) > RANK_4];
@@ -220,53 +118,242 @@ namespace {
   }
 
   template <PieceType pt>
-  Bitboard lame_leaper_attack(Square s, Bitboard occupied) {
+  constexpr Bitboard lame_leaper_attack(Square s, Bitboard occupied) {
     Bitboard b = 0;
-    for (const auto& d : pt == BISHOP  ? BishopDirections : KnightDirections)
+    for (Direction d : leaper_directions<pt>())
     {
       Square to = s + d;
-      if (is_ok(to) && distance(s, to) < 4 && !(lame_leaper_path<pt>(d, s) & occupied))
-        b |= to;
+      if (is_ok(to) && square_distance(s, to) < 4 && !(lame_leaper_path<pt>(d, s) & occupied))
+        b |= bb(to);
     }
     if (pt == BISHOP)
       b &= HalfBB[rank_of(s) > RANK_4];
     return b;
   }
 
+  template <Color C>
+  constexpr Bitboard pawn_attack(Square s) {
+    Bitboard attack = safe_destination(s, C == WHITE ? NORTH : SOUTH);
+    if ((C == WHITE && rank_of(s) > RANK_4) || (C == BLACK && rank_of(s) < RANK_5))
+      attack |= safe_destination(s, WEST) | safe_destination(s, EAST);
+    return attack;
+  }
+
+  template <Color C>
+  constexpr Bitboard pawn_attack_to(Square s) {
+    Bitboard attack = safe_destination(s, C == WHITE ? SOUTH : NORTH);
+    if ((C == WHITE && rank_of(s) > RANK_4) || (C == BLACK && rank_of(s) < RANK_5))
+      attack |= safe_destination(s, WEST) | safe_destination(s, EAST);
+    return attack;
+  }
+
+  constexpr auto make_popcnt16() {
+    std::array<uint8_t, 1 << 16> t{};
+    for (unsigned i = 1; i < (1 << 16); ++i)
+        t[i] = uint8_t(t[i >> 1] + (i & 1));
+    return t;
+  }
+
+  constexpr auto make_square_distance() {
+    std::array<std::array<uint8_t, SQUARE_NB>, SQUARE_NB> t{};
+    for (Square s1 = SQ_A0; s1 <= SQ_I9; ++s1)
+        for (Square s2 = SQ_A0; s2 <= SQ_I9; ++s2)
+            t[s1][s2] = uint8_t(square_distance(s1, s2));
+    return t;
+  }
+
+  constexpr auto make_square_bb() {
+    std::array<Bitboard, SQUARE_NB> t{};
+    for (Square s = SQ_A0; s <= SQ_I9; ++s)
+        t[s] = bb(s);
+    return t;
+  }
+
+  constexpr auto make_pawn_attacks(bool to) {
+    std::array<std::array<Bitboard, SQUARE_NB>, COLOR_NB> t{};
+    for (Square s = SQ_A0; s <= SQ_I9; ++s)
+    {
+        t[WHITE][s] = to ? pawn_attack_to<WHITE>(s) : pawn_attack<WHITE>(s);
+        t[BLACK][s] = to ? pawn_attack_to<BLACK>(s) : pawn_attack<BLACK>(s);
+    }
+    return t;
+  }
+
+  constexpr auto make_pseudo_attacks() {
+    std::array<std::array<Bitboard, SQUARE_NB>, PIECE_TYPE_NB> t{};
+    for (Square s = SQ_A0; s <= SQ_I9; ++s)
+    {
+        t[  ROOK][s] = sliding_attack<ROOK>(s, 0);
+        t[BISHOP][s] = lame_leaper_attack<BISHOP>(s, 0);
+        t[KNIGHT][s] = lame_leaper_attack<KNIGHT>(s, 0);
+
+        // Only generate pseudo attacks in the palace squares for king and advisor
+        if (Palace & bb(s)) {
+            for (int step : { NORTH, SOUTH, WEST, EAST } )
+                t[KING][s] |= safe_destination(s, step);
+            t[KING][s] &= Palace;
+
+            for (int step : { NORTH_WEST, NORTH_EAST, SOUTH_WEST, SOUTH_EAST } )
+                t[ADVISOR][s] |= safe_destination(s, step);
+            t[ADVISOR][s] &= Palace;
+        }
+    }
+    return t;
+  }
 
-  // init_magics() computes all rook and bishop attacks at startup. Magic
-  // bitboards are used to look up attacks of sliding pieces. As a reference see
+  // LineBB and BetweenBB of rook aligned squares are the whole rank or file
+  // and the squares walked from s1 to s2. The squares are aligned iff they
+  // share a rank or a file, so the sliding attacks are not needed.
+
+  constexpr auto make_line_bb() {
+    std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> t{};
+    for (Square s1 = SQ_A0; s1 <= SQ_I9; ++s1)
+        for (Square s2 = SQ_A0; s2 <= SQ_I9; ++s2)
+            if (s1 != s2 && (rank_of(s1) == rank_of(s2) || file_of(s1) == file_of(s2)))
+                t[s1][s2] = rank_of(s1) == rank_of(s2) ? rank_bb(s1) : file_bb(s1);
+    return t;
+  }
+
+  constexpr auto make_between_bb() {
+    std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> t{};
+    for (Square s1 = SQ_A0; s1 <= SQ_I9; ++s1)
+    {
+        Bitboard knight = lame_leaper_attack<KNIGHT>(s1, 0);
+
+        for (Square s2 = SQ_A0; s2 <= SQ_I9; ++s2)
+        {
+            if (s1 != s2 && (rank_of(s1) == rank_of(s2) || file_of(s1) == file_of(s2)))
+            {
+                Direction d = rank_of(s1) == rank_of(s2) ? (s2 > s1 ? EAST : WEST)
+                                                         : (s2 > s1 ? NORTH : SOUTH);
+                for (Square s = s1 + d; s != s2; s += d)
+                    t[s1][s2] |= bb(s);
+            }
+
+            if (knight & bb(s2))
+                t[s1][s2] |= lame_leaper_path<KNIGHT_TO>(Direction(s2 - s1), s1);
+
+            t[s1][s2] |= bb(s2);
+        }
+    }
+    return t;
+  }
+
+} // namespace
+
+const std::array<uint8_t, 1 << 16> PopCnt16 = make_popcnt16();
+const std::array<std::array<uint8_t, SQUARE_NB>, SQUARE_NB> SquareDistance = make_square_distance();
+
+const std::array<Bitboard, SQUARE_NB> SquareBB = make_square_bb();
+const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> LineBB = make_line_bb();
+const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> BetweenBB = make_between_bb();
+const std::array<std::array<Bitboard, SQUARE_NB>, PIECE_TYPE_NB> PseudoAttacks = make_pseudo_attacks();
+const std::array<std::array<Bitboard, SQUARE_NB>, COLOR_NB> PawnAttacks = make_pawn_attacks(false);
+const std::array<std::array<Bitboard, SQUARE_NB>, COLOR_NB> PawnAttacksTo = make_pawn_attacks(true);
+
+Magic RookMagics[SQUARE_NB];
+Magic CannonMagics[SQUARE_NB];
+Magic BishopMagics[SQUARE_NB];
+Magic KnightMagics[SQUARE_NB];
+Magic KnightToMagics[SQUARE_NB];
+
+namespace {
+
+  uint16_t RookIndices  [0x108000];  // To store rook attack indices
+  uint16_t CannonIndices[0x108000];  // To store cannon attack indices
+  Bitboard RookTable    [0x35E8];    // To store distinct rook attacks
+  Bitboard CannonTable  [0x2522A];   // To store distinct cannon attacks
+  Bitboard BishopTable  [0x228];     // To store bishop attacks
+  Bitboard KnightTable  [0x380];     // To store knight attacks
+  Bitboard KnightToTable[0x3E0];     // To store by knight attacks
+
+  template <PieceType pt>
+  void init_magics(Bitboard table[], Magic magics[], const Bitboard magicsInit[]);
+
+  template <PieceType pt, size_t TableSize, size_t IndicesSize>
+  void init_compact_magics(Bitboard (&table)[TableSize], uint16_t (&indices)[IndicesSize],
+                           Magic magics[], const Bitboard magicsInit[]);
+
+}
+
+
+/// Bitboards::pretty() returns an ASCII representation of a bitboard suitable
+/// to be printed to standard output. Useful for debugging.
+
+std::string Bitboards::pretty(Bitboard b) {
+
+  std::string s = "+---+---+---+---+---+---+---+---+---+\n";
+
+  for (Rank r = RANK_9; r >= RANK_0; --r)
+  {
+      for (File f = FILE_A; f <= FILE_I; ++f)
+          s += b & make_square(f, r) ? "| X " : "|   ";
+
+      s += "| " + std::to_string(r) + "\n+---+---+---+---+---+---+---+---+---+\n";
+  }
+  s += "  a   b   c   d   e   f   g   h   i\n";
+
+  return s;
+}
+
+
+/// Bitboards::init() initializes the magic bitboard tables. It is called at
+/// startup, the other bitboard tables are generated at compile time.
+
+void Bitboards::init() {
+
+  init_compact_magics<  ROOK>(RookTable,     RookIndices,     RookMagics, RookMagicsInit);
+  init_compact_magics<CANNON>(CannonTable, CannonIndices, CannonMagics, RookMagicsInit);
+
+  init_magics<   BISHOP>(  BishopTable,   BishopMagics,   BishopMagicsInit);
+  init_magics<   KNIGHT>(  KnightTable,   KnightMagics,   KnightMagicsInit);
+  init_magics<KNIGHT_TO>(KnightToTable, KnightToMagics, KnightToMagicsInit);
+}
+
+namespace {
+
+  // init_magic() sets the mask, shift and magic number of a square. Board edges
+  // are not considered in the relevant occupancies, and the index must be big
+  // enough to contain all the attacks for each possible subset of the mask and
+  // so is 2 power the number of 1s of the mask.
+
+  template <PieceType pt>
+  void init_magic(Magic& m, Square s, Bitboard magic) {
+
+    Bitboard edges = ((Rank0BB | Rank9BB) & ~rank_bb(s)) | ((FileABB | FileIBB) & ~file_bb(s));
+
+    // Given a square 's', the mask is the bitboard of sliding attacks from
+    // 's' computed on an empty board.
+    m.mask = pt == ROOK   ? sliding_attack<pt>(s, 0) :
+             pt == CANNON ? RookMagics[s].mask       :
+                            lame_leaper_path<pt>(s)  ;
+    if (pt != KNIGHT_TO)
+      m.mask &= ~edges;
+
+    if (HasPext)
+      m.shift = popcount(uint64_t(m.mask));
+    else
+      m.shift = 128 - popcount(m.mask);
+
+    m.magic = magic;
+  }
+
+
+  // init_magics() computes all bishop and knight attacks at startup. Magic
+  // bitboards are used to look up attacks of lame leapers. As a reference see
   // www.chessprogramming.org/Magic_Bitboards. In particular, here we use the so
   // called "fancy" approach.
 
   template <PieceType pt>
   void init_magics(Bitboard table[], Magic magics[], const Bitboard magicsInit[]) {
 
-    Bitboard edges, b;
+    Bitboard b;
     uint64_t size = 0;
 
     for (Square s = SQ_A0; s <= SQ_I9; ++s)
     {
-        // Board edges are not considered in the relevant occupancies
-        edges = ((Rank0BB | Rank9BB) & ~rank_bb(s)) | ((FileABB | FileIBB) & ~file_bb(s));
-
-        // Given a square 's', the mask is the bitboard of sliding attacks from
-        // 's' computed on an empty board. The index must be big enough to contain
-        // all the attacks for each possible subset of the mask and so is 2 power
-        // the number of 1s of the mask.
         Magic& m = magics[s];
-        m.mask = pt == ROOK   ? sliding_attack<pt>(s, 0) :
-                 pt == CANNON ? RookMagics[s].mask       :
-                                lame_leaper_path<pt>(s)  ;
-        if (pt != KNIGHT_TO)
-          m.mask &= ~edges;
-
-        if (HasPext)
-          m.shift = popcount(uint64_t(m.mask));
-        else
-          m.shift = 128 - popcount(m.mask);
-
-        m.magic = magicsInit[s];
+        init_magic<pt>(m, s, magicsInit[s]);
 
         // Set the offset for the attacks table of the square. We have individual
         // table sizes for each square with "Fancy Magic Bitboards".
@@ -276,14 +363,107 @@ namespace {
         // store the corresponding attack bitboard in m.attacks.
         b = size = 0;
         do {
-            m.attacks[m.index(b)] = pt == ROOK || pt == CANNON ? sliding_attack<pt>(s, b) :
-                                                                 lame_leaper_attack<pt>(s, b);
+            m.attacks[m.index(b)] = lame_leaper_attack<pt>(s, b);
 
             size++;
             b = (b - m.mask) & m.mask;
         } while (b);
     }
   }
+
+
+  // init_compact_magics() computes the compact rook and cannon tables: each
+  // square stores only its distinct attack sets, plus a 16-bit index into them
+  // per occupancy. The four rays of a slider are independent, so a distinct
+  // attack set is a combination of one attack per ray, and its index is
+  // ((n * E + e) * S + s) * W + w, where n, e, s, w are the attack numbers on
+  // each ray and E, S, W the number of different attacks on those rays.
+  //
+  // Instead of computing a sliding attack for each of the 2^N occupancies we
+  // walk the occupancies of the four rays in nested loops. For disjoint subsets
+  // of the mask both the pext index and the magic product are additive, so the
+  // index of an occupancy is the sum of the precomputed keys of its rays.
+
+  template <PieceType pt, size_t TableSize, size_t IndicesSize>
+  void init_compact_magics(Bitboard (&table)[TableSize], uint16_t (&indices)[IndicesSize],
+                           Magic magics[], const Bitboard magicsInit[]) {
+
+    struct Ray {
+      Bitboard keys[1 << 8];     // Index or magic product of each ray occupancy
+      uint16_t attack[1 << 8];   // Attack number of each ray occupancy
+      Bitboard attacks[1 << 8];  // Distinct attacks on the ray
+      int occupancies, count;
+    } rays[4];
+
+    uint64_t size = 0, count = 0;
+
+    for (Square s = SQ_A0; s <= SQ_I9; ++s)
+    {
+        Magic& m = magics[s];
+        init_magic<pt>(m, s, magicsInit[s]);
+
+        m.indices = s == SQ_A0 ? indices : magics[s - 1].indices + size;
+        m.attacks = s == SQ_A0 ? table   : magics[s - 1].attacks + count;
+
+        int r = 0;
+        for (Direction d : { NORTH, EAST, SOUTH, WEST })
+        {
+            Ray& ray = rays[r++];
+            Bitboard line = 0, b = 0;
+
+            for (Square t = s + d; is_ok(t) && distance(t - d, t) == 1; t += d)
+                line |= t;
+
+            // Enumerate the occupancies of the ray with the Carry-Rippler trick
+            ray.occupancies = ray.count = 0;
+            do {
+                Bitboard attack = sliding_attack<pt>(s, b) & line;
+                int i = 0;
+                while (i < ray.count && ray.attacks[i] != attack)
+                    ++i;
+                if (i == ray.count)
+                    ray.attacks[ray.count++] = attack;
+
+                ray.keys[ray.occupancies] = HasPext ? Bitboard(m.index(b)) : b * m.magic;
+                ray.attack[ray.occupancies++] = uint16_t(i);
+                b = (b - (m.mask & line)) & (m.mask & line);
+            } while (b);
+        }
+
+        const Ray &n = rays[0], &e = rays[1], &so = rays[2], &w = rays[3];
+
+        // The sizes of the tables are the exact totals, check that they hold
+        assert(m.attacks + uint64_t(n.count) * e.count * so.count * w.count <= table + TableSize);
+        assert(m.indices + uint64_t(n.occupancies) * e.occupancies * so.occupancies * w.occupancies <= indices + IndicesSize);
+
+        Bitboard* attacks = m.attacks;
+        for (int i = 0; i < n.count; ++i)
+            for (int j = 0; j < e.count; ++j)
+                for (int k = 0; k < so.count; ++k)
+                    for (int l = 0; l < w.count; ++l)
+                        *attacks++ = n.attacks[i] | e.attacks[j] | so.attacks[k] | w.attacks[l];
+
+        assert(n.count * e.count * so.count * w.count <= 0x10000);
+
+        for (int i = 0; i < n.occupancies; ++i)
+            for (int j = 0; j < e.occupancies; ++j)
+            {
+                Bitboard key = n.keys[i] + e.keys[j];
+                int attack = n.attack[i] * e.count + e.attack[j];
+
+                for (int k = 0; k < so.occupancies; ++k)
+                    for (int l = 0; l < w.occupancies; ++l)
+                    {
+                        Bitboard idx = key + so.keys[k] + w.keys[l];
+                        m.indices[HasPext ? unsigned(idx) : unsigned(idx >> m.shift)] =
+                            uint16_t((attack * so.count + so.attack[k]) * w.count + w.attack[l]);
+                    }
+            }
+
+        size = uint64_t(n.occupancies) * e.occupancies * so.occupancies * w.occupancies;
+        count = uint64_t(n.count) * e.count * so.count * w.count;
+    }
+  }
 }
 
 } // namespace Stockfish
@@ -19,10 +19,15 @@
 #ifndef BITBOARD_H_INCLUDED
 #define BITBOARD_H_INCLUDED
 
+#include <array>
 #include <string>
 
 #include "types.h"
 
+#if defined(USE_NUMA)
+#include "numa.h"
+#endif
+
 namespace Stockfish {
 
 namespace Bitboards {
@@ -62,23 +67,27 @@ constexpr Bitboard HalfBB[2] = { Rank0BB | Rank1BB | Rank2BB | Rank3BB | Rank4BB
 constexpr Bitboard PawnBB[2] = { HalfBB[BLACK] | ((Rank3BB | Rank4BB) & PawnFileBB),
                                  HalfBB[WHITE] | ((Rank6BB | Rank5BB) & PawnFileBB) };
 
-extern uint8_t PopCnt16[1 << 16];
-extern uint8_t SquareDistance[SQUARE_NB][SQUARE_NB];
+extern const std::array<uint8_t, 1 << 16> PopCnt16;
+extern const std::array<std::array<uint8_t, SQUARE_NB>, SQUARE_NB> SquareDistance;
 
-extern Bitboard SquareBB[SQUARE_NB];
-extern Bitboard BetweenBB[SQUARE_NB][SQUARE_NB];
-extern Bitboard LineBB[SQUARE_NB][SQUARE_NB];
-extern Bitboard PseudoAttacks[PIECE_TYPE_NB][SQUARE_NB];
-extern Bitboard PawnAttacks[COLOR_NB][SQUARE_NB];
-extern Bitboard PawnAttacksTo[COLOR_NB][SQUARE_NB];
+extern const std::array<Bitboard, SQUARE_NB> SquareBB;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> BetweenBB;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> LineBB;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, PIECE_TYPE_NB> PseudoAttacks;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, COLOR_NB> PawnAttacks;
+extern const std::array<std::array<Bitboard, SQUARE_NB>, COLOR_NB> PawnAttacksTo;
 
 int popcount(Bitboard b); // required for 128 bit pext
 
 /// Magic holds all magic bitboards relevant data for a single square
+/// Rook and cannon attacks are stored compactly: 'attacks' holds the distinct
+/// attack sets of the square and 'indices' maps each occupancy index to one of
+/// them. The small lame leaper tables are indexed directly.
 struct Magic {
   Bitboard  mask;
   Bitboard  magic;
   Bitboard* attacks;
+  uint16_t* indices;
   unsigned  shift;
 
   // Compute the attack's index using the 'magic bitboards' approach
@@ -97,6 +106,25 @@ extern Magic BishopMagics[SQUARE_NB];
 extern Magic KnightMagics[SQUARE_NB];
 extern Magic KnightToMagics[SQUARE_NB];
 
+/// magic() returns the magic entry of the given piece type and square, read
+/// from the thread's node local copy of the tables when NUMA replication is used.
+
+template<PieceType Pt>
+inline const Magic& magic(Square s) {
+
+#if defined(USE_NUMA)
+  return (Pt == ROOK   ? Numa::Local.rookMagics   :
+          Pt == CANNON ? Numa::Local.cannonMagics :
+          Pt == BISHOP ? Numa::Local.bishopMagics :
+          Pt == KNIGHT ? Numa::Local.knightMagics : Numa::Local.knightToMagics)[s];
+#else
+  return (Pt == ROOK   ? RookMagics   :
+          Pt == CANNON ? CannonMagics :
+          Pt == BISHOP ? BishopMagics :
+          Pt == KNIGHT ? KnightMagics : KnightToMagics)[s];
+#endif
+}
+
 inline Bitboard square_bb(Square s) {
   assert(is_ok(s));
   return SquareBB[s];
@@ -203,7 +231,11 @@ inline Bitboard line_bb(Square s1, Square s2) {
 
   assert(is_ok(s1) && is_ok(s2));
 
+#if defined(USE_NUMA)
+  return (*Numa::Local.lineBB)[s1][s2];
+#else
   return LineBB[s1][s2];
+#endif
 }
 
 
@@ -219,7 +251,11 @@ inline Bitboard between_bb(Square s1, Square s2) {
 
   assert(is_ok(s1) && is_ok(s2));
 
+#if defined(USE_NUMA)
+  return (*Numa::Local.betweenBB)[s1][s2];
+#else
   return BetweenBB[s1][s2];
+#endif
 }
 
 
@@ -266,11 +302,11 @@ inline Bitboard attacks_bb(Square s, Bitboard occupied) {
 
   switch (Pt)
   {
-  case ROOK     : return     RookMagics[s].attacks[    RookMagics[s].index(occupied)];
-  case CANNON   : return   CannonMagics[s].attacks[  CannonMagics[s].index(occupied)];
-  case BISHOP   : return   BishopMagics[s].attacks[  BishopMagics[s].index(occupied)];
-  case KNIGHT   : return   KnightMagics[s].attacks[  KnightMagics[s].index(occupied)];
-  case KNIGHT_TO: return KnightToMagics[s].attacks[KnightToMagics[s].index(occupied)];
+  case ROOK     :
+  case CANNON   : return magic<Pt>(s).attacks[magic<Pt>(s).indices[magic<Pt>(s).index(occupied)]];
+  case BISHOP   :
+  case KNIGHT   :
+  case KNIGHT_TO: return magic<Pt>(s).attacks[magic<Pt>(s).index(occupied)];
   default       : return PseudoAttacks[Pt][s];
   }
 }
@@ -0,0 +1,279 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+#include "book.h"
+#include "engine.h"
+#include "position.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace Stockfish {
+
+namespace {
+
+  // Game is a game of a PGN file, with its moves in coordinate notation
+
+  struct Game {
+    string fen = StartFEN;
+    vector<string> moves;
+    string result = "*";
+  };
+
+
+  // read_pgn() reads the next game of a PGN file. The moves may be in ICCS
+  // notation (H2-E2), as written by "selfplay", or in coordinate notation.
+  // A game without result ends at the tags of the next one, which are kept
+  // in 'pending' for the next call.
+
+  bool read_pgn(istream& in, string& pending, Game& game) {
+
+    string line, token;
+    game = Game();
+
+    while (!pending.empty() ? (line = pending, pending.clear(), true) : bool(getline(in, line)))
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        if (line.empty() || line[0] == '%')
+            continue;
+
+        if (line[0] == '[')
+        {
+            if (!game.moves.empty())
+            {
+                pending = line;
+                return true;
+            }
+
+            size_t q1 = line.find('"'), q2 = line.rfind('"');
+            if (q1 == string::npos || q2 <= q1)
+                continue;
+
+            if (line.compare(1, 4, "FEN ") == 0)
+                game.fen = line.substr(q1 + 1, q2 - q1 - 1);
+            else if (line.compare(1, 7, "Result ") == 0)
+                game.result = line.substr(q1 + 1, q2 - q1 - 1);
+
+            continue;
+        }
+
+        // Remove the comments, which are assumed not to span several lines
+        for (size_t b; (b = line.find('{')) != string::npos; )
+            line.erase(b, line.find('}', b) == string::npos ? string::npos : line.find('}', b) - b + 1);
+
+        istringstream is(line);
+
+        while (is >> token)
+        {
+            if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*")
+                return true;
+
+            token = token.substr(token.rfind('.') == string::npos ? 0 : token.rfind('.') + 1);
+
+            if (token.length() == 5 && token[2] == '-')
+                token = { char(tolower(token[0])), token[1], char(tolower(token[3])), token[4] };
+
+            if (token.length() == 4)
+                game.moves.push_back(token);
+        }
+    }
+
+    return !game.moves.empty();
+  }
+
+} // namespace
+
+
+/// Book::open() maps a book file, replacing the current one. It returns false
+/// if the file is not a valid book, the book is then closed.
+
+bool Book::open(const string& fname) {
+
+  close();
+
+  if (!file.open(fname) || file.size() < sizeof(Header))
+  {
+      file.close();
+      return false;
+  }
+
+  const Header* h = static_cast<const Header*>(file.data());
+
+  if (   h->magic != Magic
+      || h->version != Version
+      || file.size() != sizeof(Header) + h->count * sizeof(Entry))
+  {
+      file.close();
+      return false;
+  }
+
+  entries = reinterpret_cast<const Entry*>(h + 1);
+  count = size_t(h->count);
+  return true;
+}
+
+
+/// Book::probe() returns a move of the book for the position, MOVE_NONE if
+/// there is none. The move of highest weight is returned if bestMove is set,
+/// otherwise a move is drawn at random according to the weights. The move
+/// may be illegal in case of a key collision, the caller must check it.
+
+Move Book::probe(const Position& pos, bool bestMove) {
+
+  if (!entries)
+      return MOVE_NONE;
+
+  Key key = pos.board_key();
+  const Entry* e = std::lower_bound(entries, entries + count, key,
+                                    [](const Entry& a, Key k) { return a.key() < k; });
+  Move move = MOVE_NONE;
+  uint32_t sum = 0, best = 0;
+
+  for ( ; e < entries + count && e->key() == key; ++e)
+  {
+      sum += e->weight;
+
+      // Keep every move with a probability proportional to its weight
+      if (bestMove ? e->weight > best : sum && rng.rand<uint32_t>() % sum < e->weight)
+      {
+          move = Move(e->move);
+          best = e->weight;
+      }
+  }
+
+  return move;
+}
+
+
+/// makebook() is called when the engine receives the "makebook" command:
+///
+/// makebook <pgn file> ... [maxply <n>] [mingames <g>] [out <file>]
+///
+/// It builds an opening book from the games of PGN files, for instance those
+/// written by "selfplay". The first n plies of every game are used (default
+/// 24) and the moves played in fewer than g games (default 1) are dropped,
+/// as are those that never scored. Unfinished games, of result "*", score no
+/// point. The book is written to "book.bin" unless another file is given.
+
+void makebook(Engine& engine, istream& args) {
+
+  string token, outFile = "book.bin";
+  vector<string> pgnFiles;
+  int maxPly = 24, minGames = 1;
+
+  while (args >> token)
+      if (token == "maxply")
+          args >> maxPly;
+      else if (token == "mingames")
+          args >> minGames;
+      else if (token == "out")
+          args >> outFile;
+      else
+          pgnFiles.push_back(token);
+
+  if (pgnFiles.empty())
+  {
+      sync_cout << "Usage: makebook <pgn file> ... [maxply <n>] [mingames <g>] [out <file>]" << sync_endl;
+      return;
+  }
+
+  // Games and points of every move, sorted like the book
+  map<pair<Key, uint16_t>, pair<int, int>> stats;
+  size_t games = 0, skipped = 0;
+  TimePoint elapsed = now();
+
+  engine.wait_for_search_finished();
+
+  for (const string& fname : pgnFiles)
+  {
+      ifstream in(fname);
+      if (!in.is_open())
+      {
+          sync_cout << "Unable to open file " << fname << sync_endl;
+          return;
+      }
+
+      string pending;
+
+      for (Game game; read_pgn(in, pending, game); )
+      {
+          StateListPtr states(new std::deque<StateInfo>(1));
+          Position pos;
+          pos.set(game.fen, &states->back(), engine.threads.main());
+          ++games;
+
+          for (int ply = 0; ply < std::min(maxPly, int(game.moves.size())); ++ply)
+          {
+              Move m = UCI::to_move(pos, game.moves[ply]);
+              if (m == MOVE_NONE)
+              {
+                  ++skipped;
+                  break;
+              }
+
+              // An unfinished game counts for 'mingames' but scores nothing
+              int points =  game.result == "*"       ? 0
+                          : game.result == "1/2-1/2" ? 1
+                          : (game.result == "1-0") == (pos.side_to_move() == WHITE) ? 2 : 0;
+
+              auto& [n, p] = stats[{ pos.board_key(), uint16_t(m) }];
+              ++n, p += points;
+
+              states->emplace_back();
+              pos.do_move(m, states->back());
+          }
+      }
+  }
+
+  vector<Book::Entry> entries;
+
+  for (const auto& [km, np] : stats)
+      if (np.first >= minGames && np.second > 0)
+          entries.push_back({ uint32_t(km.first), uint32_t(km.first >> 32), km.second,
+                              uint16_t(std::min(np.second, 0xFFFF)) });
+
+  Book::Header h = { Book::Magic, Book::Version, entries.size() };
+  ofstream out(outFile, ios::binary);
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Book::Entry));
+
+  if (!out)
+  {
+      sync_cout << "Unable to write file " << outFile << sync_endl;
+      return;
+  }
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  sync_cout << "\n==========================="
+            << "\nGames           : " << games
+            << "\nIllegal moves   : " << skipped
+            << "\nBook entries    : " << entries.size()
+            << "\nTotal time (ms) : " << elapsed << sync_endl;
+}
+
+} // namespace Stockfish
@@ -0,0 +1,76 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOOK_H_INCLUDED
+#define BOOK_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+#include "misc.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+/// Book is an opening book built by the "makebook" command. The file is a
+/// header followed by 12 bytes entries sorted by key, in host byte order:
+///
+/// key     64 bit  Position::board_key(), as two 32 bit halves, low first
+/// move    16 bit  the move played in the position
+/// weight  16 bit  2 points for a won game, 1 for a draw, for the side to move
+///
+/// The file is memory mapped and probed with a binary search.
+
+class Book {
+
+public:
+  struct Entry {
+    uint32_t keyLo, keyHi;
+    uint16_t move, weight;
+
+    Key key() const { return Key(keyHi) << 32 | keyLo; }
+  };
+
+  struct Header {
+    uint32_t magic, version;
+    uint64_t count;
+  };
+
+  static constexpr uint32_t Magic = 0x4B424B50; // "PKBK"
+  static constexpr uint32_t Version = 1;
+
+  bool open(const std::string& fname);
+  void close() { file.close(); entries = nullptr; count = 0; }
+  bool is_open() const { return entries != nullptr; }
+  Move probe(const Position& pos, bool bestMove);
+
+private:
+  MappedFile file;
+  const Entry* entries = nullptr;
+  size_t count = 0;
+  PRNG rng = PRNG(uint64_t(now()) | 1);
+};
+
+static_assert(sizeof(Book::Entry) == 12, "Unexpected Book::Entry size");
+static_assert(sizeof(Book::Header) == 16, "Unexpected Book::Header size");
+
+} // namespace Stockfish
+
+#endif // #ifndef BOOK_H_INCLUDED
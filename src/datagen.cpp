@@ -0,0 +1,328 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "datagen.h"
+#include "engine.h"
+#include "misc.h"
+#include "position.h"
+#include "selfplay.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace Stockfish {
+
+namespace {
+
+  const string PieceToChar(" RACPNBK racpnbk");
+
+  // Writer appends the records to the output file through a large buffer.
+  // An optional filter drops the positions already written: it is a direct
+  // mapped table of keys, so a few duplicates can slip through once it fills.
+
+  class Writer {
+
+    static constexpr size_t BufferSize = 1 << 16; // Records
+
+  public:
+    Writer(const string& file, size_t dedupeMB) : out(file, ios::binary | ios::app) {
+      buffer.reserve(BufferSize);
+      if (dedupeMB)
+          keys.resize(dedupeMB * 1024 * 1024 / sizeof(Key));
+    }
+   ~Writer() { flush(); }
+
+    bool is_open() const { return out.is_open(); }
+    uint64_t written() const { return count; }
+
+    // write() returns false if the position is dropped as a duplicate
+    bool write(const PackedPosition& pp, Key key) {
+
+      if (!keys.empty())
+      {
+          Key& k = keys[mul_hi64(key, keys.size())];
+          if (k == key)
+              return false;
+          k = key;
+      }
+
+      buffer.push_back(pp);
+      ++count;
+
+      if (buffer.size() >= BufferSize)
+          flush();
+
+      return true;
+    }
+
+    void flush() {
+      out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(PackedPosition));
+      out.flush();
+      buffer.clear();
+    }
+
+  private:
+    ofstream out;
+    vector<PackedPosition> buffer;
+    vector<Key> keys;
+    uint64_t count = 0;
+  };
+
+} // namespace
+
+
+/// PackedPosition::pack() packs a position with its score and game result,
+/// both from the point of view of the side to move.
+
+PackedPosition PackedPosition::pack(const Position& pos, Value score, int result) {
+
+  PackedPosition pp;
+  std::memset(&pp, 0, sizeof(pp));
+
+  int n = 0;
+  for (Square s = SQ_A0; s <= SQ_I9; ++s)
+      if (Piece pc = pos.piece_on(s); pc != NO_PIECE)
+      {
+          pp.occupied[s / 8] |= 1 << (s % 8);
+          pp.pieces[n / 2] |= pc << (4 * (n % 2));
+          ++n;
+      }
+
+  pp.occupied[11] |= (pos.side_to_move() == BLACK) << 2;
+  pp.score  = int16_t(std::clamp(score, -VALUE_INFINITE, VALUE_INFINITE));
+  pp.result = int8_t(result);
+  pp.rule60 = uint8_t(std::clamp(pos.rule60_count(), 0, 255));
+  return pp;
+}
+
+
+/// PackedPosition::fen() returns the FEN of a packed position. The move number
+/// is not stored, so it is always 1.
+
+string PackedPosition::fen() const {
+
+  Piece board[SQUARE_NB] = {};
+  int n = 0;
+
+  for (Square s = SQ_A0; s <= SQ_I9; ++s)
+      if (occupied[s / 8] & (1 << (s % 8)))
+      {
+          board[s] = Piece((pieces[n / 2] >> (4 * (n % 2))) & 0xF);
+          ++n;
+      }
+
+  std::ostringstream ss;
+
+  for (Rank r = RANK_9; r >= RANK_0; --r)
+  {
+      for (File f = FILE_A; f <= FILE_I; ++f)
+      {
+          int emptyCnt = 0;
+          for ( ; f <= FILE_I && !board[make_square(f, r)]; ++f)
+              ++emptyCnt;
+
+          if (emptyCnt)
+              ss << emptyCnt;
+
+          if (f <= FILE_I)
+              ss << PieceToChar[board[make_square(f, r)]];
+      }
+
+      if (r > RANK_0)
+          ss << '/';
+  }
+
+  ss << (side_to_move() == WHITE ? " w" : " b") << " - - " << int(rule60) << " 1";
+  return ss.str();
+}
+
+
+/// datagen() is called when the engine receives the "datagen" command:
+///
+/// datagen <file>|startpos depth|nodes <n> [games <g>] [jobs <j>] [out <file>]
+///         [random <plies>] [dedupe <MB>] [maxplies <m>] [seed <s>]
+///
+/// It plays g selfplay games, j at a time (by default one per thread of the
+/// "Threads" option), and appends their positions to a file of PackedPosition
+/// records (default "data.bin"). Each game starts from an opening of the file,
+/// followed by some random moves (default 8). Positions in check, with a mate
+/// score or where the search played a capture are skipped, since they are of
+/// little use to fit a static evaluation. With 'dedupe', a filter of the given
+/// size drops the positions already written.
+
+void datagen(Engine& engine, istream& args) {
+
+  string token, openingFile, limitType, outFile = "data.bin";
+  int64_t limit = 0;
+  size_t games = 1, jobs = size_t(engine.options["Threads"]), dedupeMB = 0;
+  int randomPlies = 8, maxPlies = 400;
+  uint64_t seed = uint64_t(now());
+
+  args >> openingFile >> limitType >> limit;
+
+  while (args >> token)
+      if (token == "games")
+          args >> games;
+      else if (token == "jobs")
+          args >> jobs;
+      else if (token == "out")
+          args >> outFile;
+      else if (token == "random")
+          args >> randomPlies;
+      else if (token == "dedupe")
+          args >> dedupeMB;
+      else if (token == "maxplies")
+          args >> maxPlies;
+      else if (token == "seed")
+          args >> seed;
+
+  if (limit <= 0 || (limitType != "depth" && limitType != "nodes"))
+  {
+      sync_cout << "Usage: datagen <file>|startpos depth|nodes <n> [games <g>] [jobs <j>] [out <file>]"
+                   " [random <plies>] [dedupe <MB>] [maxplies <m>] [seed <s>]" << sync_endl;
+      return;
+  }
+
+  vector<string> openings;
+
+  if (openingFile == "startpos")
+      openings.push_back(StartFEN);
+  else
+  {
+      ifstream file(openingFile);
+      if (!file.is_open())
+      {
+          sync_cout << "Unable to open file " << openingFile << sync_endl;
+          return;
+      }
+
+      string line;
+      while (getline(file, line))
+          if (line.find_first_not_of(" \t\r") != string::npos)
+              openings.push_back(line);
+
+      if (openings.empty())
+          return;
+  }
+
+  Writer writer(outFile, dedupeMB);
+  if (!writer.is_open())
+  {
+      sync_cout << "Unable to open file " << outFile << sync_endl;
+      return;
+  }
+
+  Search::LimitsType limits;
+  if (limitType == "depth")
+      limits.depth = int(limit);
+  else
+      limits.nodes = limit;
+
+  jobs = std::clamp(jobs, size_t(1), std::max(games, size_t(1)));
+  size_t hashMB = std::max(size_t(engine.options["Hash"]) / (2 * jobs), size_t(1));
+  atomic<size_t> next(0);
+  atomic<uint64_t> totalNodes(0);
+  uint64_t finished = 0, duplicates = 0;
+  mutex writerMutex;
+  vector<thread> workers;
+
+  engine.wait_for_search_finished();
+  TimePoint elapsed = now();
+
+  for (size_t j = 0; j < jobs; ++j)
+      workers.emplace_back([&] {
+
+          Engine red, black;
+          Engine* engines[] = { &red, &black };
+          vector<pair<PackedPosition, Key>> records;
+
+          for (Engine* e : engines)
+          {
+              e->onOutput = nullptr;
+              e->set_option("Hash", std::to_string(hashMB));
+          }
+
+          for (size_t idx = next++; idx < games; idx = next++)
+          {
+              SelfPlay::Game game = SelfPlay::play(engines, openings[idx % openings.size()], limits,
+                                                   maxPlies, randomPlies, (seed ^ (idx << 20)) | 1);
+              totalNodes += game.nodes;
+
+              if (game.result == "*")
+                  continue;
+
+              // Replay the game to pack its positions
+              int whiteResult = game.result == "1-0" ? 1 : game.result == "0-1" ? -1 : 0;
+              StateListPtr states(new std::deque<StateInfo>(1));
+              Position pos;
+              pos.set(game.fen, &states->back(), red.threads.main());
+              records.clear();
+
+              for (size_t i = 0; i < game.moves.size(); ++i)
+              {
+                  Move m = game.moves[i];
+                  Value v = game.scores[i];
+
+                  if (   !pos.checkers()
+                      && abs(v) < VALUE_MATE_IN_MAX_PLY
+                      && !pos.capture(m))
+                      records.emplace_back(PackedPosition::pack(pos, v,
+                                               pos.side_to_move() == WHITE ? whiteResult : -whiteResult),
+                                           pos.key());
+
+                  states->emplace_back();
+                  pos.do_move(m, states->back());
+              }
+
+              std::lock_guard<mutex> lk(writerMutex);
+
+              for (const auto& [pp, key] : records)
+                  duplicates += !writer.write(pp, key);
+
+              if (++finished % 100 == 0)
+                  sync_cout << "Games " << finished << ", positions " << writer.written()
+                            << ", nodes/second " << 1000 * totalNodes / (now() - elapsed + 1) << sync_endl;
+          }
+      });
+
+  for (thread& th : workers)
+      th.join();
+
+  writer.flush();
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  sync_cout << "\n==========================="
+            << "\nGames           : " << finished
+            << "\nPositions       : " << writer.written()
+            << "\nDuplicates      : " << duplicates
+            << "\nTotal time (ms) : " << elapsed
+            << "\nNodes searched  : " << totalNodes
+            << "\nNodes/second    : " << 1000 * totalNodes / elapsed << sync_endl;
+}
+
+} // namespace Stockfish
@@ -0,0 +1,58 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef DATAGEN_H_INCLUDED
+#define DATAGEN_H_INCLUDED
+
+#include <cstdint>
+#include <string>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+/// PackedPosition is the 32 bytes record of the training data files written
+/// by "datagen", stored in host byte order:
+///
+/// occupied  90 bit  squares SQ_A0 .. SQ_I9 holding a piece, LSB first
+/// black      1 bit  bit 90 of occupied, set if black is to move
+/// pieces   32x4 bit the pieces of the occupied squares in square order, low nibble first
+/// score     16 bit  score of the search, for the side to move
+/// result     8 bit  result of the game for the side to move: 1 win, 0 draw, -1 loss
+/// rule60     8 bit  Position::rule60_count()
+
+struct PackedPosition {
+
+  static PackedPosition pack(const Position& pos, Value score, int result);
+  std::string fen() const;
+  Color side_to_move() const { return Color((occupied[11] >> 2) & 1); }
+
+  uint8_t occupied[12];
+  uint8_t pieces[16];
+  int16_t score;
+  int8_t  result;
+  uint8_t rule60;
+};
+
+static_assert(sizeof(PackedPosition) == 32, "Unexpected PackedPosition size");
+
+} // namespace Stockfish
+
+#endif // #ifndef DATAGEN_H_INCLUDED
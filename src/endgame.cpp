@@ -23,8 +23,101 @@
 #include "endgame.h"
 #include "movegen.h"
 
+using std::string;
+
 namespace Stockfish {
 
+namespace {
+
+  // Used to build the endgame codes of the families of material configurations
+  string n_of(int n, char pt) { return string(n, pt); }
+
+  // Defenders of a side, any number of advisors and bishops
+  template<typename F>
+  void for_each_defenders(F f) {
+    for (int a = 0; a <= 2; ++a)
+        for (int b = 0; b <= 2; ++b)
+            f(n_of(a, 'A') + n_of(b, 'B'), a, b);
+  }
+
+  // Value of a known win for the strong side, from the side to move's point of view
+  Value known_win(const Position& pos, Color strongSide, Value bonus) {
+
+    Value result =  VALUE_KNOWN_WIN + bonus
+                  + pos.material(strongSide) - pos.material(~strongSide);
+
+    return strongSide == pos.side_to_move() ? result : -result;
+  }
+
+} // namespace
+
+
+namespace Endgames {
+
+  std::pair<Map<Value>, Map<ScaleFactor>> maps;
+
+  /// Endgames::init() registers the endgames by material key. Most endgames
+  /// cover a family of material configurations, for instance any number of
+  /// advisors and bishops of the strong side, so every member is added.
+
+  void init() {
+
+    for (int r = 1; r <= 2; ++r)
+        for_each_defenders([&](const string& strong, int, int) {
+
+            // 车(任意士象) vs 士象全(任意兵卒)
+            for (int p = 0; p <= 5; ++p)
+                add<KAABBKR>("K" + n_of(r, 'R') + strong + "KAABB" + n_of(p, 'P'));
+
+            // 车(任意士象) vs 士象不全
+            for_each_defenders([&](const string& weak, int a, int b) {
+                if (a + b < 4)
+                    add<KRKAB>("K" + n_of(r, 'R') + strong + "K" + weak);
+            });
+        });
+
+    for_each_defenders([&](const string& strong, int a, int) {
+
+        // 马(任意士象) vs 象
+        for (int n = 1; n <= 2; ++n)
+            add<KBKN>("K" + n_of(n, 'N') + strong + "KB");
+
+        // 车(任意士象) vs 马, 车(任意士象) vs 炮
+        add<KRKN>("KR" + strong + "KN");
+        add<KRKC>("KR" + strong + "KC");
+
+        // 炮仕(任意士象) vs 将
+        if (a)
+            add<KCAK>("KC" + strong + "K");
+
+        // 马兵(任意士象) vs 任意士象
+        for_each_defenders([&](const string& weak, int, int) {
+            add<KNPKAB>("KNP" + strong + "K" + weak);
+        });
+    });
+
+    // 兵 vs 卒
+    add<KPKP>("KPKP");
+
+    // Draw by insufficient material, without pawns, rooks and knights: no
+    // cannons, a single cannon without advisors on the board or a bare cannon
+    // against a single advisor, or a bare cannon each.
+    for_each_defenders([&](const string& strong, int a1, int b1) {
+        for_each_defenders([&](const string& weak, int a2, int) {
+
+            add<INSUFFICIENT_MATERIAL>("K" + strong + "K" + weak);
+
+            if (a1 + a2 == 0 || (a1 + b1 == 0 && a2 == 1))
+                add<INSUFFICIENT_MATERIAL>("KC" + strong + "K" + weak);
+        });
+    });
+
+    add<INSUFFICIENT_MATERIAL>("KCKC");
+  }
+
+} // namespace Endgames
+
+
 template<>
 Value Endgame<KAABBKR>::operator()(const Position& pos) const {
 
@@ -144,4 +237,64 @@ Value Endgame<INSUFFICIENT_MATERIAL>::operator()(const Position& pos) const {
     return Value(16);
 }
 
+
+/// Rook against incomplete defenders is a win, the material term drives the
+/// capture of the remaining defenders.
+template<>
+Value Endgame<KRKAB>::operator()(const Position& pos) const {
+
+    assert(!pos.checkers()); // Eval is never called when in check
+
+    return known_win(pos, strongSide, VALUE_ZERO);
+}
+
+/// Rook against knight or cannon is a win once the defending piece is cut off
+/// from its king, so keep them apart.
+template<>
+Value Endgame<KRKN>::operator()(const Position& pos) const {
+
+    assert(!pos.checkers()); // Eval is never called when in check
+
+    int d = distance(pos.square<KING>(weakSide), pos.square<KNIGHT>(weakSide));
+    return known_win(pos, strongSide, Value(16 * d));
+}
+
+template<>
+Value Endgame<KRKC>::operator()(const Position& pos) const {
+
+    assert(!pos.checkers()); // Eval is never called when in check
+
+    int d = distance(pos.square<KING>(weakSide), pos.square<CANNON>(weakSide));
+    return known_win(pos, strongSide, Value(16 * d));
+}
+
+/// Cannon and advisor against a bare king is a win, the advisor serving as
+/// the screen of the cannon. Restrict the moves of the defending king.
+template<>
+Value Endgame<KCAK>::operator()(const Position& pos) const {
+
+    assert(!pos.checkers()); // Eval is never called when in check
+
+    Square ksq = pos.square<KING>(weakSide);
+    int mobility = popcount(attacks_bb<KING>(ksq) & ~pos.pieces(weakSide));
+    return known_win(pos, strongSide, Value(16 * (4 - mobility)));
+}
+
+/// Knight and pawn against defenders: a pawn on the last rank is of no use
+/// against an advisor, and a pawn on the rank below cannot break the full set
+/// of defenders, so scale down the evaluation in both cases.
+template<>
+ScaleFactor Endgame<KNPKAB>::operator()(const Position& pos) const {
+
+    Rank r = relative_rank(strongSide, pos.square<PAWN>(strongSide));
+
+    if (r == RANK_9 && pos.count<ADVISOR>(weakSide))
+        return ScaleFactor(8);
+
+    if (r == RANK_8 && pos.count<ADVISOR>(weakSide) + pos.count<BISHOP>(weakSide) == 4)
+        return ScaleFactor(16);
+
+    return SCALE_FACTOR_NONE;
+}
+
 } // namespace Stockfish
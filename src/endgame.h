@@ -39,7 +39,13 @@ enum EndgameCode {
   KPKP,
   KBKN,
   INSUFFICIENT_MATERIAL,
+  KRKAB,    // Rook against incomplete defenders
+  KRKN,     // Rook against knight
+  KRKC,     // Rook against cannon
+  KCAK,     // Cannon and advisor against bare king
+
   SCALING_FUNCTIONS,
+  KNPKAB    // Knight and pawn against defenders
 };
 
 
@@ -70,6 +76,39 @@ struct Endgame : public EndgameBase<T> {
   T operator()(const Position&) const override;
 };
 
+
+/// The Endgames namespace handles the pointers to endgame evaluation and scaling
+/// base objects in two std::unordered_map. We use polymorphism to invoke the
+/// actual endgame function by calling its virtual operator().
+
+namespace Endgames {
+
+  template<typename T> using Ptr = std::unique_ptr<EndgameBase<T>>;
+  template<typename T> using Map = std::unordered_map<Key, Ptr<T>>;
+
+  extern std::pair<Map<Value>, Map<ScaleFactor>> maps;
+
+  void init();
+
+  template<typename T>
+  Map<T>& map() {
+    return std::get<std::is_same<T, ScaleFactor>::value>(maps);
+  }
+
+  template<EndgameCode E, typename T = eg_type<E>>
+  void add(const std::string& code) {
+
+    map<T>()[Position::material_key(code, WHITE)] = Ptr<T>(new Endgame<E>(WHITE));
+    map<T>()[Position::material_key(code, BLACK)] = Ptr<T>(new Endgame<E>(BLACK));
+  }
+
+  template<typename T>
+  const EndgameBase<T>* probe(Key key) {
+    auto it = map<T>().find(key);
+    return it != map<T>().end() ? it->second.get() : nullptr;
+  }
+}
+
 } // namespace Stockfish
 
 #endif // #ifndef ENDGAME_H_INCLUDED
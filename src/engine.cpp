@@ -0,0 +1,276 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <mutex>
+
+#include "bitbase.h"
+#include "bitboard.h"
+#include "endgame.h"
+#include "engine.h"
+#include "evaluate.h"
+#include "misc.h"
+#include "psqt.h"
+
+namespace Stockfish {
+
+/// Engine::init() builds the read-only tables shared by all the engines. It
+/// is called by the constructor, only the first call does something.
+
+void Engine::init() {
+
+  static std::once_flag once;
+
+  std::call_once(once, [] {
+      PSQT::init();
+      Bitboards::init();
+      Position::init();
+      Endgames::init();
+  });
+}
+
+
+/// Engine constructor sets the options to their default values and launches
+/// the threads, which also allocates and clears the hash. An engine may search
+/// in the hash of another one, which must outlive it.
+
+Engine::Engine(TranspositionTable* sharedTT) : tt(sharedTT ? *sharedTT : ownTT), threads(*this), time(threads),
+                   onOutput([](const std::string& str) { async_cout(str); }) {
+
+  init();
+  UCI::init(options, *this);
+  threads.set(size_t(options["Threads"]));
+  set_position(StartFEN);
+}
+
+
+/// Engine destructor stops the search and joins the threads
+
+Engine::~Engine() {
+
+  stop();
+  threads.set(0);
+}
+
+
+/// Engine::set_option() sets an option, returning false if there is no option
+/// of this name. Invalid values are silently ignored, as with "setoption".
+
+bool Engine::set_option(const std::string& name, const std::string& value) {
+
+  if (!options.count(name))
+      return false;
+
+  options[name] = value;
+  return true;
+}
+
+
+/// Engine::set_position() sets the root of the next search to the position
+/// after the given moves, in coordinate notation, from the given FEN. It
+/// returns false, keeping the moves up to the first illegal one, if a move
+/// can not be played. GUIs send the whole game before every search, so when
+/// the FEN is the same only the moves that differ from the current ones are
+/// taken back and played, the other states are kept.
+
+bool Engine::set_position(const std::string& fen, const std::vector<std::string>& moves) {
+
+  wait_for_search_finished();
+
+  if (!states)
+      states = threads.release_states(); // Of the last search, which is finished
+
+  size_t n = 0;
+
+  if (states && fen == posFen)
+      while (n < moves.size() && n < posMoves.size() && moves[n] == UCI::move(posMoves[n]))
+          ++n;
+  else
+  {
+      states = StateListPtr(new std::deque<StateInfo>(1)); // Drop the old state and create a new one
+      pos.set(fen, &states->back(), threads.main());
+      posFen = fen;
+      posMoves.clear();
+  }
+
+  while (posMoves.size() > n)
+  {
+      pos.undo_move(posMoves.back());
+      posMoves.pop_back();
+      states->pop_back();
+  }
+
+  for (size_t i = n; i < moves.size(); ++i)
+  {
+      std::string token = moves[i];
+      Move m = UCI::to_move(pos, token);
+      if (m == MOVE_NONE)
+          return false;
+
+      states->emplace_back();
+      pos.do_move(m, states->back());
+      posMoves.push_back(m);
+  }
+
+  return true;
+}
+
+
+/// Engine::go() starts a search of the position given by set_position() and
+/// returns immediately. The result is available once wait_for_search_finished()
+/// returns. The search clock starts now unless limits.startTime is set.
+
+void Engine::go(const Search::LimitsType& lim, bool ponderMode) {
+
+  if (lim.startTime)
+      threads.start_thinking(pos, states, lim, ponderMode);
+  else
+  {
+      Search::LimitsType l = lim;
+      l.startTime = now();
+      threads.start_thinking(pos, states, l, ponderMode);
+  }
+}
+
+
+/// Engine::search() searches the position given by set_position() and blocks
+/// until the search is finished. Limits must be finite: with 'infinite' or
+/// 'ponder' it only returns after stop() is called from another thread.
+
+Engine::Result Engine::search(const Search::LimitsType& lim) {
+
+  go(lim);
+  wait_for_search_finished();
+  return result;
+}
+
+
+/// Engine::clear() resets the search state to its initial value, before a new game
+
+void Engine::clear() {
+
+  wait_for_search_finished();
+
+  time.availableNodes = 0;
+  threads.clear();
+
+  if (!shares_tt())
+      tt.clear(threads.size());
+}
+
+
+/// Engine::load_book() opens the opening book of a file, or closes the book
+/// if the name is empty.
+
+bool Engine::load_book(const std::string& fname) {
+
+  wait_for_search_finished();
+
+  if (fname.empty() || fname == "<empty>")
+  {
+      book.close();
+      return true;
+  }
+
+  if (!book.open(fname))
+  {
+      output("info string ERROR: the book file " + fname + " could not be loaded");
+      return false;
+  }
+
+  output("info string Book file " + fname + " loaded");
+  return true;
+}
+
+
+/// Engine::load_eval() replaces the evaluation parameters by the ones of a file,
+/// see Eval::load_params(). They are process wide, but only the material tables,
+/// the hash and the position of this engine are updated for them. The hash is
+/// cleared, as its static evaluations were computed with the old parameters.
+
+bool Engine::load_eval(const std::string& fname) {
+
+  wait_for_search_finished();
+
+  if (!Eval::load_params(fname))
+  {
+      output("info string ERROR: the eval file " + fname + " could not be loaded");
+      return false;
+  }
+
+  for (Thread* th : threads)
+      th->materialTable.clear();
+
+  if (!shares_tt())
+      tt.clear(threads.size());
+
+  // The incremental PSQT score of the position is computed again by playing
+  // the game from its FEN, so that its history is kept for the repetitions.
+  std::string fen = posFen.empty() ? pos.fen() : posFen;
+  std::vector<std::string> moves;
+
+  if (!posFen.empty())
+      for (Move m : posMoves)
+          moves.push_back(UCI::move(m));
+
+  posFen.clear(); // Force a new position
+  set_position(fen, moves);
+
+  output("info string Eval file " + fname + " loaded");
+  return true;
+}
+
+
+/// Engine::load_bitbases() maps the bitbases of a list of directories, see
+/// Bitbases::init(). They are process wide.
+
+void Engine::load_bitbases(const std::string& paths) {
+
+  wait_for_search_finished();
+
+  size_t n = Bitbases::init(paths);
+  output("info string Found " + std::to_string(n) + " bitbases");
+}
+
+
+/// Engine::resize_hash() sets the hash size in MB, the table is cleared
+
+void Engine::resize_hash(size_t mbSize) {
+
+  wait_for_search_finished();
+
+  if (!shares_tt())
+      tt.resize(mbSize, threads.size());
+}
+
+
+/// Engine::resize_threads() sets the number of search threads, and reports
+/// the memory of their tables.
+
+void Engine::resize_threads(size_t requested) {
+
+  threads.set(requested);
+  posFen.clear(); // The position may refer to an old main thread, set it again
+
+  if (requested)
+      output("info string Using " + std::to_string(requested) + " threads, "
+             + std::to_string(Thread::memory() >> 20) + " MB of tables each, "
+             + std::to_string((requested * Thread::memory()) >> 20) + " MB in total");
+}
+
+} // namespace Stockfish
@@ -0,0 +1,120 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ENGINE_H_INCLUDED
+#define ENGINE_H_INCLUDED
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "book.h"
+#include "position.h"
+#include "search.h"
+#include "thread.h"
+#include "timeman.h"
+#include "tt.h"
+#include "types.h"
+#include "uci.h"
+
+namespace Stockfish {
+
+/// FEN string of the initial position in standard xiangqi
+constexpr const char* StartFEN = "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w";
+
+/// Engine keeps together everything a search needs: the UCI options, the
+/// transposition table, the thread pool, the search limits and the time
+/// manager. Several engines can live in one process and search at the same
+/// time, they only share the read-only tables (bitboards, magics, PSQT and
+/// Zobrist keys) that are built once by the first engine. The rule options
+/// (Sixty Move Rule, Strict Three Fold, Chase With Check, Full Evaluation)
+/// the evaluation parameters (EvalFile) and the bitbases (BitbasePath) are
+/// process wide, so all the engines of a process must agree on them.
+///
+/// Besides the UCI program, the class is the C++ API of libpikafish:
+///
+///   Engine engine;
+///   engine.set_option("Hash", "64");
+///   engine.set_position(StartFEN, { "h2e2", "h9g7" });
+///   Search::LimitsType limits;
+///   limits.depth = 12;
+///   Engine::Result r = engine.search(limits);
+
+class Engine {
+public:
+  struct Result {
+    Move bestMove = MOVE_NONE;
+    Move ponderMove = MOVE_NONE;
+    Value score = VALUE_NONE;
+    Depth depth = 0;
+    uint64_t nodes = 0;
+    std::vector<Move> pv;
+  };
+
+  explicit Engine(TranspositionTable* sharedTT = nullptr);
+ ~Engine();
+  Engine(const Engine&) = delete;
+  Engine& operator=(const Engine&) = delete;
+
+  static void init();
+
+  bool set_option(const std::string& name, const std::string& value);
+  bool set_position(const std::string& fen, const std::vector<std::string>& moves = {});
+  void go(const Search::LimitsType& limits, bool ponderMode = false);
+  Result search(const Search::LimitsType& limits);
+  void stop() { threads.stop_searching(); }
+  void ponderhit() { threads.ponderhit(); }
+  void wait_for_search_finished() { threads.main()->wait_for_search_finished(); }
+  const Position& position() const { return pos; }
+  void flip() { wait_for_search_finished(); pos.flip(); posFen.clear(); }
+
+  void clear();
+  bool load_book(const std::string& fname);
+  bool load_eval(const std::string& fname);
+  void load_bitbases(const std::string& paths);
+  void resize_hash(size_t mbSize);
+  void resize_threads(size_t requested);
+  void output(const std::string& str) const { if (onOutput) onOutput(str); }
+  bool shares_tt() const { return &tt != &ownTT; }
+
+  // Members are constructed in this order: the pool and the time manager
+  // refer to the other ones.
+  UCI::OptionsMap options;
+  TranspositionTable& tt; // Owned unless shared, then only its owner resizes and clears it
+  ThreadPool threads;
+  Search::LimitsType limits;
+  TimeManagement time;
+  Result result; // Of the last search, set by the main thread before "bestmove"
+  Book book;     // Of the "Book" option, probed when a search starts
+
+  // Receives the "info" and "bestmove" lines of the searches. It queues them
+  // for stdout by default, library users may replace it or reset it to mute
+  // the engine. It is called from the search threads.
+  std::function<void(const std::string&)> onOutput;
+
+private:
+  TranspositionTable ownTT;
+  Position pos;
+  StateListPtr states;
+  std::string posFen;         // Of the last set_position(), with the moves
+  std::vector<Move> posMoves; // played from it to reach 'pos'
+};
+
+} // namespace Stockfish
+
+#endif // #ifndef ENGINE_H_INCLUDED
@@ -0,0 +1,194 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef EVALPARAMS_H_INCLUDED
+#define EVALPARAMS_H_INCLUDED
+
+#include "types.h"
+
+// The parameters of the classical evaluation. This file is written by the
+// "texel" command, which tunes them on a set of positions.
+
+namespace Stockfish::Eval {
+
+#define S(mg, eg) make_score(mg, eg)
+
+// Cannon on the central file facing the king, with its advisors home and no
+// piece in between
+constexpr Score HollowCannon = S(  85,  91);
+
+// Cannon on the central file pinning a knight in the center of the palace
+constexpr Score CentralKnight = S(  50,  53);
+
+// Cannon on the enemy back rank facing the king
+constexpr Score BottomCannon = S(  18,   8);
+
+// Both advisors and both bishops
+constexpr Score AdvisorBishopPair = S(  24, -43);
+
+// Pawns side by side
+constexpr Score ConnectedPawn = S(   5,  -5);
+
+// Knight on the edge of the board between a rook of each side
+constexpr Score TrappedKnight = S(  -5,  -2);
+
+// Pawns across the river, not on the last rank, by number of enemy advisors
+// and number of such pawns
+constexpr Score CrossedPawn[3][6] = {
+  { S( -56, -40), S(   6,  24), S(  11,   7), S( -29,   7), S(  -9,  -1), S(  -4,  -7) },
+  { S( -68, -35), S(  10,  12), S(   9,   3), S( -16,   9), S( -14,   0), S( -36, -13) },
+  { S( -79,   5), S(  40,  -8), S(  32,   1), S( -22,   9), S( -20, -16), S( -40, -20) },
+};
+
+// Rook on a semi-open file, by whether the file is open
+constexpr Score RookOnOpenFile[2] = { S(   0,  -8), S(  14,  16) };
+
+// Rooks, knights and cannons across the river on one wing of the board and
+// not attacked, by their number
+constexpr Score PiecesOnOneSide[5] = { S(  -3,   5), S( -13,  36), S(  18,  26), S(   9,  26), S(  10,  -4) };
+
+// Mobility by piece type and number of squares attacked that are not attacked
+// by enemy pawns, in hundredths
+constexpr Score MobilityBonus[PIECE_TYPE_NB][18] = {
+  { },
+  { S(-2655,-3045), S( 423,-2895), S(-1144,-2170), S( 155,-3012), S(-1067,-5183), S(1097,-3787), S(2037,-2581), S(2577,-3604), S(3512,-3371), S(3554,-5076), S(5818,-4178), S(6629,-946), S(8410,-3079), S(9004,-1200), S(11081,-3500), S(9035,-1212), S(11433,-3483), S(1686,-4329) }, // ROOK
+  { S(1686,-4329), S(4461, 745), S(4657, 329), S(5853,1929), S(9140, 275), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // ADVISOR
+  { S( 672,1629), S(-310,1438), S(1799,1728), S( 840,4456), S( 115,3069), S(1085,3029), S( 624,3532), S(-1894,3181), S(-1461,3018), S(-461,2196), S(-1398,5107), S( 568,4268), S(-1408,5591), S(-933,5727), S(-2136,6283), S(-478,7094), S(  35,6741), S(-2309,6672) }, // CANNON
+  { }, // PAWN
+  { S(-582,-4894), S(2260,-2360), S(4002,-2435), S(4595,1090), S(5389,2949), S(9760,3209), S(8500,3453), S(11956,6472), S(13619,7657), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // KNIGHT
+  { S(1692,-2811), S( 911,-1898), S(3017,-904), S(7134,1537), S(9276,-1351), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // BISHOP
+  { }, // KING
+};
+
+// Material imbalance, one parameter for each pair (our piece, another of our
+// pieces), in sixteenths
+constexpr Score QuadraticOurs[6][6] = {
+  { S(  71,   3), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // ROOK
+  { S(  24,  74), S(  44, -67), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // ADVISOR
+  { S(  48,  72), S(  33,  62), S(  -5, -63), S(   0,   0), S(   0,   0), S(   0,   0) }, // CANNON
+  { S(  75, -14), S(  31,  44), S(  -3,  28), S( -11,  11), S(   0,   0), S(   0,   0) }, // PAWN
+  { S( -92,  53), S(  27,  -9), S(  -3, 234), S(  44,  88), S( -30, -29), S(   0,   0) }, // KNIGHT
+  { S(  54, 104), S( 175,-103), S( 106, -64), S(  43,-113), S(  24,   6), S(   2, -59) }, // BISHOP
+};
+
+// Material imbalance, one parameter for each pair (our piece, their piece),
+// in sixteenths
+constexpr Score QuadraticTheirs[6][6] = {
+  { S( -35, -46), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // ROOK
+  { S( -92,  32), S( 138,  -7), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) }, // ADVISOR
+  { S( -83,  13), S( -41,  43), S(  20,  28), S(   0,   0), S(   0,   0), S(   0,   0) }, // CANNON
+  { S(  -2,  13), S( -57,-118), S( -18, 121), S(  70, -58), S(   0,   0), S(   0,   0) }, // PAWN
+  { S( -37,  17), S(  14, -86), S(  38, -24), S(  67,  43), S( -21, -42), S(   0,   0) }, // KNIGHT
+  { S(  72,  38), S(   6, -79), S(  24,  -2), S(  48,  30), S(  30,  14), S( -51,  35) }, // BISHOP
+};
+
+// Piece-square bonus, added to the piece values. Scores are explicit for files
+// A to E, implicitly mirrored for E to I.
+constexpr Score Bonus[PIECE_TYPE_NB][RANK_NB][int(FILE_NB) / 2 + 1] = {
+  { },
+  { // ROOK
+    { S(-203,-131), S(  46,-225), S(-147, -86), S( -17,   5), S(   8, -13) },
+    { S(-203, -52), S(  58, -67), S( -89,-110), S( -78, 121), S(-106, 106) },
+    { S(-138, -61), S(   7, -96), S( -65,  -9), S(-110,   7), S(  -8,  45) },
+    { S( -60,  77), S( -48, -33), S( -58,  61), S(  88,  54), S( 175,  -4) },
+    { S( -61,  32), S(  42,  -7), S(-112,  34), S( 181,  13), S(-170,  14) },
+    { S( -69, -12), S( 192,  24), S(  88, -76), S(  53, -74), S( 110,  86) },
+    { S(-199, 103), S(  -8, -85), S( 179, -39), S(  48,  23), S(  12,  79) },
+    { S( 139, 130), S(  20,-149), S(  95, 113), S(  92, 101), S( -20, -69) },
+    { S( -72, -15), S( 163, -21), S( 124, -79), S(  32,  46), S( -78,-100) },
+    { S( 109, -97), S(  66, -29), S( -86,  -4), S(  39,  55), S(  22,  54) },
+  },
+  { // ADVISOR
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(  41,  33), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(  38, 113) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(-152,  47), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+  },
+  { // CANNON
+    { S(  -4,  15), S( -42, -59), S( -44, -53), S(  61, 124), S(   4,  34) },
+    { S(  38,   6), S( 141, -34), S( -63,  22), S(  -1,  37), S( 113,  41) },
+    { S(  21, -24), S(  72, -11), S(  58,  82), S( 104,  60), S( 212,  42) },
+    { S(  35, 106), S(-194, -36), S( 112,  97), S( 102,-151), S(  -2, -43) },
+    { S( -40, -30), S( -56,  78), S( -82,  32), S(-113, 136), S( 246,   6) },
+    { S( -66,  13), S(  66,-102), S(   2,  40), S(  -7,  34), S(  79, 112) },
+    { S(  51,-196), S( 100, -46), S(  20, -34), S(   1,  52), S(  48, 163) },
+    { S( 149,-165), S( -13,  84), S(  -2,   9), S(  67,-107), S( 180,  58) },
+    { S( -48, 100), S(  55, -17), S(  -2,  16), S( -42, -91), S(  88,  51) },
+    { S( 135, -53), S( 225, -12), S( -15,  26), S( 189, 144), S(  13,  12) },
+  },
+  { // PAWN
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S( -27, -19), S(   0,   0), S( -19, -27), S(   0,   0), S(  56,  34) },
+    { S( -12, -18), S(   0,   0), S(  41,  -2), S(   0,   0), S(  39,  61) },
+    { S( -28,  70), S( -53,  93), S( 138,  46), S(  26, 197), S(  73,  52) },
+    { S( -74,  69), S(-145,  80), S(  53, 161), S(   2, 210), S( -65,  22) },
+    { S(  91, -92), S(-120, 104), S(  18,  41), S(  19,  46), S(-121, -67) },
+    { S(-181,-148), S(  50,  56), S( 182,  34), S(  11,  41), S(  62,  17) },
+    { S( 116, -57), S(  85, -85), S( -84,   3), S(  35, -33), S(  19,-119) },
+  },
+  { // KNIGHT
+    { S( -25, -48), S(-180,-201), S( -30, -32), S(-112,-133), S( -99,  56) },
+    { S(-126, -95), S( -93,  59), S(-142, -26), S( -37, -82), S( -64,-136) },
+    { S( -82, -88), S(  43, -51), S( -35,-109), S(  11,  54), S(  -4, -16) },
+    { S(  25,   7), S( -86,-111), S(  82, -30), S( 172, -90), S( -36, 101) },
+    { S(-154,  35), S( -58,  68), S(   5,  89), S(  26, -50), S( 103,  56) },
+    { S( 117, -34), S(  70,  66), S(  43, -50), S( 151,  74), S( -53, 110) },
+    { S( -62, -72), S(  62,  47), S( 170,  63), S(  26,  34), S( -74,  -2) },
+    { S( 122, -69), S( -69,-134), S(   4,  25), S(  78, 151), S(   1, 198) },
+    { S(-107, -19), S( -69, -57), S( -11, 100), S( -64, -74), S( 187, 125) },
+    { S( -53,  20), S(  12, 139), S(  30, -12), S(-139, -79), S( -65,  25) },
+  },
+  { // BISHOP
+    { S(   0,   0), S(   0,   0), S( 111, 129), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(  18, 105), S(   0,   0), S(   0,   0), S(   0,   0), S( 206, 148) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(  -4, 102), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+  },
+  { // KING
+    { S(   0,   0), S(   0,   0), S(   0,   0), S( -74,  42), S(  63,  65) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(-221, -16), S( -71,  63) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   1,-167), S( -36, -59) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+    { S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0), S(   0,   0) },
+  },
+};
+
+#undef S
+
+} // namespace Stockfish::Eval
+
+#endif // #ifndef EVALPARAMS_H_INCLUDED
@@ -29,10 +29,13 @@
 
 #include "bitboard.h"
 #include "evaluate.h"
+#include "evalparams.h"
 #include "misc.h"
+#include "psqt.h"
 #include "thread.h"
 #include "uci.h"
 #include "material.h"
+#include "texel.h"
 
 using namespace std;
 
@@ -46,7 +49,7 @@ namespace Trace {
         MATERIAL = 8, IMBALANCE, PAIR, MOBILITY, THREAT, PIECES, WINNABLE, TOTAL, TERM_NB
     };
 
-    Score scores[TERM_NB][COLOR_NB];
+    thread_local Score scores[TERM_NB][COLOR_NB];
 
     double to_cp(Value v) { return double(v) / PawnValueEg; }
 
@@ -83,30 +86,7 @@ using namespace Trace;
 
 namespace {
 
-#define S(mg, eg) make_score(mg, eg)
-    constexpr Score HollowCannon = S(85, 91);
-    constexpr Score CentralKnight = S(50, 53);
-    constexpr Score BottomCannon = S(18, 8);
-    constexpr Score AdvisorBishopPair = S(24, -43);
-    constexpr Score CrossedPawn[3][6] = {
-        { S(-56, -40), S(6, 24), S(11, 7), S(-29, 7), S(-9, -1), S(-4, -7) },
-        { S(-68, -35), S(10, 12), S(9, 3), S(-16, 9), S(-14, 0), S(-36, -13) },
-        { S(-79, 5), S(40, -8), S(32, 1), S(-22, 9), S(-20, -16), S(-40, -20) }
-    };
-    constexpr Score ConnectedPawn = S(5, -5);
-    constexpr Score TrappedKnight = S(-5, -2);
-    constexpr Score RookOnOpenFile[2] = { S(0, -8), S(14, 16) };
-    constexpr Score PiecesOnOneSide[5] = { S(-3, 5), S(-13, 36), S(18, 26), S(9, 26), S(10, -4) };
-    constexpr Score mobilityBonus[PIECE_TYPE_NB][18] = {
-        {}, // NO_PIECE_TYPE
-        {S(-2655, -3045), S(423, -2895), S(-1144, -2170), S(155, -3012), S(-1067, -5183), S(1097, -3787), S(2037, -2581), S(2577, -3604), S(3512, -3371), S(3554, -5076), S(5818, -4178), S(6629, -946), S(8410, -3079), S(9004, -1200), S(11081, -3500), S(9035, -1212), S(11433, -3483), S(1686, -4329)}, // ROOK
-        {S(1686, -4329), S(4461, 745), S(4657, 329), S(5853, 1929), S(9140, 275)}, // ADVISOR
-        {S(672, 1629), S(-310, 1438), S(1799, 1728), S(840, 4456), S(115, 3069), S(1085, 3029), S(624, 3532), S(-1894, 3181), S(-1461, 3018), S(-461, 2196), S(-1398, 5107), S(568, 4268), S(-1408, 5591), S(-933, 5727), S(-2136, 6283), S(-478, 7094), S(35, 6741), S(-2309, 6672)}, // CANNON
-        {}, // PAWN
-        {S(-582, -4894), S(2260, -2360), S(4002, -2435), S(4595, 1090), S(5389, 2949), S(9760, 3209), S(8500, 3453), S(11956, 6472), S(13619, 7657)}, // KNIGHT
-        {S(1692, -2811), S(911, -1898), S(3017, -904), S(7134, 1537), S(9276, -1351)}, // BISHOP
-    };
-#undef S
+    using namespace Eval;
 
     // Evaluation class computes and stores attacks tables and other working data
     template<Tracing T>
@@ -114,7 +94,7 @@ namespace {
 
     public:
         Evaluation() = delete;
-        explicit Evaluation(const Position& p) : pos(p) {}
+        explicit Evaluation(const Position& p, int* c = nullptr) : pos(p), coefficients(c) {}
         Evaluation& operator=(const Evaluation&) = delete;
         Value value();
 
@@ -123,10 +103,15 @@ namespace {
         template<Color Us, PieceType Pt> Score pieces();
         template<Color Us> Score threat();
         Value winnable(Score score) const;
+        template<Color Us> void trace(int param, int n = 1) const;
 
         const Position& pos;
         Material::Entry* me;
 
+        // coefficients[] counts the uses of each evaluation parameter, with
+        // the sign of the side using it, when tracing for the tuner.
+        int* coefficients;
+
         // attackedBy[color][piece type] is a bitboard representing all squares
         // attacked by a given color and piece type. Special "piece types" which
         // is also calculated is ALL_PIECES.
@@ -140,6 +125,18 @@ namespace {
     };
 
 
+    // Evaluation::trace() adds n uses of an evaluation parameter by the given
+    // color to the coefficients of a traced evaluation.
+
+    template<Tracing T> template<Color Us>
+    void Evaluation<T>::trace(int param, int n) const {
+
+        if constexpr (T)
+            if (coefficients)
+                coefficients[param] += Us == WHITE ? n : -n;
+    }
+
+
     // Evaluation::initialize() computes king and pawn attacks, and the king ring
     // bitboard for a given color. This is done at the beginning of the evaluation.
 
@@ -183,7 +180,8 @@ namespace {
             attackedBy[Us][ALL_PIECES] |= b;
 
             int mob = popcount(b & ~attackedBy[Them][PAWN]);
-            mobility[Us] += mobilityBonus[Pt][mob];
+            mobility[Us] += params.MobilityBonus[Pt][mob];
+            trace<Us>(Texel::MOBILITY_BONUS + Pt * 18 + mob);
 
             if constexpr (Pt == CANNON) { // 炮的评估
                 int blocker = popcount(between_bb(s, ksq) & pos.pieces()) - 1;
@@ -191,28 +189,35 @@ namespace {
                 Bitboard advisorBB = pos.pieces(Them, ADVISOR);
                 if (file_of(s) == FILE_E && (ksq == SQ_E0 || ksq == SQ_E9) && popcount(originalAdvisor & advisorBB) == 2) {
                     if (!blocker) { // 空头炮
-                        score += HollowCannon;
+                        score += params.HollowCannon;
+                        trace<Us>(Texel::HOLLOW_CANNON);
                     }
                     if (blocker == 2 && (between_bb(s, ksq) & pos.pieces(Them, KNIGHT) & attackedBy[Them][KING])) { // 炮镇窝心马
-                        score += CentralKnight;
+                        score += params.CentralKnight;
+                        trace<Us>(Texel::CENTRAL_KNIGHT);
                     }
                 }
                 Rank enemyBottom = (Us == WHITE ? RANK_9 : RANK_0);
                 Square enemyCenter = (Us == WHITE ? SQ_E8 : SQ_E1);
                 if (rank_of(s) == enemyBottom && !blocker && (ksq == SQ_E0 || ksq == SQ_E9) && (pos.pieces(Them) & enemyCenter)) { // 沉底炮
-                    score += BottomCannon;
+                    score += params.BottomCannon;
+                    trace<Us>(Texel::BOTTOM_CANNON);
                 }
             }
             if constexpr (Pt == ROOK)
             {
                 if (pos.is_on_semiopen_file(Us, s))
-                    score += RookOnOpenFile[pos.is_on_semiopen_file(Them, s)];
+                {
+                    score += params.RookOnOpenFile[pos.is_on_semiopen_file(Them, s)];
+                    trace<Us>(Texel::ROOK_ON_OPEN_FILE + pos.is_on_semiopen_file(Them, s));
+                }
             }
             if constexpr (Pt == KNIGHT)
             {
                 Bitboard aroundBB = shift<NORTH>(square_bb(s)) | shift<SOUTH>(square_bb(s)) | shift<EAST>(square_bb(s)) | shift<WEST>(square_bb(s));
                 if ((s & (FileABB | FileIBB | Rank0BB | Rank9BB)) && (pos.pieces(Them, ROOK) & aroundBB) && (pos.pieces(Us, ROOK) & aroundBB)) {
-                    score += TrappedKnight;
+                    score += params.TrappedKnight;
+                    trace<Us>(Texel::TRAPPED_KNIGHT);
                 }
             }
         }
@@ -225,13 +230,19 @@ namespace {
         constexpr Color Them = ~Us;
         // 士象全
         if (pos.count<ADVISOR>(Us) + pos.count<BISHOP>(Us) == 4)
-            score += AdvisorBishopPair;
+        {
+            score += params.AdvisorBishopPair;
+            trace<Us>(Texel::ADVISOR_BISHOP_PAIR);
+        }
         // 过河兵
         constexpr Bitboard crossedWithoutBottom = (Us == WHITE ? (Rank5BB | Rank6BB | Rank7BB | Rank8BB) : (Rank1BB | Rank2BB | Rank3BB | Rank4BB)); // 底线不算
         int crossedPawnCnt = popcount(crossedWithoutBottom & pos.pieces(Us, PAWN));
-        score += CrossedPawn[pos.count<ADVISOR>(Them)][crossedPawnCnt];
+        score += params.CrossedPawn[pos.count<ADVISOR>(Them)][crossedPawnCnt];
+        trace<Us>(Texel::CROSSED_PAWN + pos.count<ADVISOR>(Them) * 6 + crossedPawnCnt);
         // 牵手兵
-        score += ConnectedPawn * popcount(shift<EAST>(pos.pieces(Us, PAWN)) & pos.pieces(Us, PAWN));
+        int connectedPawnCnt = popcount(shift<EAST>(pos.pieces(Us, PAWN)) & pos.pieces(Us, PAWN));
+        score += params.ConnectedPawn * connectedPawnCnt;
+        trace<Us>(Texel::CONNECTED_PAWN, connectedPawnCnt);
         constexpr Bitboard crossed = (Us == WHITE ? (Rank5BB | Rank6BB | Rank7BB | Rank8BB | Rank9BB) : (Rank0BB | Rank1BB | Rank2BB | Rank3BB | Rank4BB));
         constexpr Bitboard left = (FileABB | FileBBB | FileCBB | FileDBB);
         constexpr Bitboard right = (FileFBB | FileGBB | FileHBB | FileIBB);
@@ -243,7 +254,8 @@ namespace {
             Bitboard side = (i == 0 ? left : right);
             int cnt = popcount(strongPieces & side & crossed & (~attackedPieces));
             cnt = cnt >= 5 ? 4 : cnt;
-            score += PiecesOnOneSide[cnt];
+            score += params.PiecesOnOneSide[cnt];
+            trace<Us>(Texel::PIECES_ON_ONE_SIDE + cnt);
         }
         return score;
     }
@@ -257,8 +269,13 @@ namespace {
     Value Evaluation<T>::winnable(Score score) const {
         int gamePhase = me->game_phase();
         Value mg = mg_value(score), eg = eg_value(score);
+
+        // Scale the endgame component for the side it favours
+        Color strongSide = eg > VALUE_DRAW ? WHITE : BLACK;
+        int sf = me->scale_factor(pos, strongSide);
+
         Value v = mg * int(gamePhase)
-            + eg * int(128 - gamePhase);
+            + eg * int(128 - gamePhase) * sf / SCALE_FACTOR_NORMAL;
         v /= 128;
         return v;
     }
@@ -300,6 +317,23 @@ namespace {
         if constexpr (T) {
             Trace::add(MATERIAL, pos.psq_score());
             Trace::add(IMBALANCE, me->imbalance());
+
+            if (coefficients)
+            {
+                // The black halves of the piece-square tables are flipped copies
+                for (Bitboard b = pos.pieces(); b; )
+                {
+                    Square s = pop_lsb(b);
+                    Piece pc = pos.piece_on(s);
+                    Square rs = color_of(pc) == WHITE ? s : flip_rank(s);
+                    int param = Texel::PSQ_BONUS + (type_of(pc) * RANK_NB + rank_of(rs)) * (FILE_NB / 2 + 1)
+                                                 + edge_distance(file_of(rs));
+
+                    coefficients[param] += color_of(pc) == WHITE ? 1 : -1;
+                }
+
+                Material::trace(pos, coefficients);
+            }
         }
 
         // Main evaluation begins here
@@ -324,12 +358,15 @@ namespace {
             Trace::add(PIECES, piecesWhite, piecesBlack);
         }
 
-        score += threat<WHITE>() - threat<BLACK>();
+        Score threatWhite = threat<WHITE>();
+        Score threatBlack = threat<BLACK>();
+
+        score += threatWhite - threatBlack;
 
         score += (mobility[WHITE] - mobility[BLACK]) / 100;
 
         if constexpr (T) {
-            Trace::add(THREAT, threat<WHITE>(), threat<BLACK>());
+            Trace::add(THREAT, threatWhite, threatBlack);
             Trace::add(MOBILITY, mobility[WHITE] / 100, mobility[BLACK] / 100);
             Trace::add(TOTAL, score);
         }
@@ -349,7 +386,6 @@ using namespace Trace;
 
 /// evaluate() is the evaluator for the outer world. It returns a static
 /// evaluation of the position from the point of view of the side to move.
-constexpr int rule60_a = 118, rule60_b = 221;
 
 Value Eval::evaluate(const Position& pos, int* complexity) {
 
@@ -359,13 +395,149 @@ Value Eval::evaluate(const Position& pos, int* complexity) {
       *complexity = abs(v - pos.material_diff());
 
   // Damp down the evaluation linearly when shuffling
-  v = v * (rule60_a - pos.rule60_count()) / rule60_b;
+  v = v * (Rule60A - pos.rule60_count()) / Rule60B;
 
   // Guarantee evaluation does not hit the mate range
   v = std::clamp(v, VALUE_MATED_IN_MAX_PLY + 1, VALUE_MATE_IN_MAX_PLY - 1);
   return v;
 }
 
+/// trace() is the evaluation seen by the tuner: the classical evaluation from
+/// white's point of view, before the rule 60 damping, with the uses of the
+/// parameters of Eval::params counted in coefficients[Texel::PARAM_NB]. The
+/// position must not be in check nor have a specialized evaluation.
+
+Value Eval::trace(const Position& pos, int coefficients[]) {
+
+  std::fill(coefficients, coefficients + Texel::PARAM_NB, 0);
+
+  Value v = Evaluation<TRACE>(pos, coefficients).value();
+
+  return pos.side_to_move() == WHITE ? v : -v;
+}
+
+namespace {
+
+  // A parameter file is a header of three 32 bit words, the magic number, the
+  // version and the number of parameters, then the mg and eg values, as 16 bit
+  // words, of the parameters in the order of Eval::Params. Everything is
+  // stored little endian.
+  constexpr uint32_t ParamsMagic = 0x43454850; // "PHEC"
+  constexpr uint32_t ParamsVersion = 1;
+
+  template<typename T>
+  void copy_table(T& to, const T& from) { std::memcpy(&to, &from, sizeof(T)); }
+
+  uint32_t read_u32(istream& in) {
+
+    unsigned char b[4] = {};
+    in.read(reinterpret_cast<char*>(b), 4);
+    return b[0] | b[1] << 8 | b[2] << 16 | uint32_t(b[3]) << 24;
+  }
+
+  int read_s16(istream& in) {
+
+    unsigned char b[2] = {};
+    in.read(reinterpret_cast<char*>(b), 2);
+    return int16_t(b[0] | b[1] << 8);
+  }
+
+  void write_u32(ostream& out, uint32_t v) {
+
+    for (int i = 0; i < 4; ++i)
+        out.put(char(v >> (8 * i)));
+  }
+
+  void write_s16(ostream& out, int v) {
+
+    out.put(char(v));
+    out.put(char(v >> 8));
+  }
+} // namespace
+
+
+Eval::Params Eval::params = Eval::default_params();
+
+
+/// default_params() returns the parameters of evalparams.h
+
+Eval::Params Eval::default_params() {
+
+  Params p;
+
+  copy_table(p.HollowCannon,      HollowCannon);
+  copy_table(p.CentralKnight,     CentralKnight);
+  copy_table(p.BottomCannon,      BottomCannon);
+  copy_table(p.AdvisorBishopPair, AdvisorBishopPair);
+  copy_table(p.ConnectedPawn,     ConnectedPawn);
+  copy_table(p.TrappedKnight,     TrappedKnight);
+  copy_table(p.CrossedPawn,       CrossedPawn);
+  copy_table(p.RookOnOpenFile,    RookOnOpenFile);
+  copy_table(p.PiecesOnOneSide,   PiecesOnOneSide);
+  copy_table(p.MobilityBonus,     MobilityBonus);
+  copy_table(p.QuadraticOurs,     QuadraticOurs);
+  copy_table(p.QuadraticTheirs,   QuadraticTheirs);
+  copy_table(p.Bonus,             Bonus);
+
+  return p;
+}
+
+
+/// load_params() replaces Eval::params by the parameters of a file written by
+/// save_params(), or by the ones of evalparams.h if the name is empty or
+/// "<internal>". The piece-square tables are rebuilt, but the positions and
+/// the material tables of the engines are not updated. If the file cannot be
+/// read, the parameters are left unchanged and false is returned.
+
+bool Eval::load_params(const std::string& fname) {
+
+  Params p = default_params();
+
+  if (!fname.empty() && fname != "<internal>")
+  {
+      ifstream in(fname, ios::binary);
+
+      if (   read_u32(in) != ParamsMagic
+          || read_u32(in) != ParamsVersion
+          || read_u32(in) != uint32_t(Texel::PARAM_NB))
+          return false;
+
+      for (int i = 0; i < Texel::PARAM_NB; ++i)
+      {
+          int mg = read_s16(in);
+          int eg = read_s16(in);
+          p.data()[i] = make_score(mg, eg);
+      }
+
+      if (!in || in.peek() != EOF)
+          return false;
+  }
+
+  params = p;
+  PSQT::init();
+  return true;
+}
+
+
+/// save_params() writes a parameter file, see load_params()
+
+bool Eval::save_params(const std::string& fname, const Params& p) {
+
+  ofstream out(fname, ios::binary);
+
+  write_u32(out, ParamsMagic);
+  write_u32(out, ParamsVersion);
+  write_u32(out, uint32_t(Texel::PARAM_NB));
+
+  for (int i = 0; i < Texel::PARAM_NB; ++i)
+  {
+      write_s16(out, mg_value(p.data()[i]));
+      write_s16(out, eg_value(p.data()[i]));
+  }
+
+  return bool(out);
+}
+
 // format_cp_compact() converts a Value into (centi)pawns and writes it in a buffer.
 // The buffer must have capacity for at least 5 chars.
 static void format_cp_compact(Value v, char* buffer) {
@@ -30,9 +30,45 @@ class Position;
 
 namespace Eval {
 
+  // Rule 60 damping of the evaluation, v * (Rule60A - rule60_count()) / Rule60B
+  constexpr int Rule60A = 118, Rule60B = 221;
+
   std::string trace(Position& pos);
+  Value trace(const Position& pos, int coefficients[]);
   Value evaluate(const Position& pos, int* complexity = nullptr);
 
+  /// Params is the flat block of the parameters of the classical evaluation,
+  /// the tables of evalparams.h in the same order. The evaluation reads them
+  /// from Eval::params, which holds the values of evalparams.h unless they
+  /// were replaced by an EvalFile. The block is process wide: it must not be
+  /// changed while an engine is searching.
+
+  struct alignas(64) Params {
+    Score HollowCannon;
+    Score CentralKnight;
+    Score BottomCannon;
+    Score AdvisorBishopPair;
+    Score ConnectedPawn;
+    Score TrappedKnight;
+    Score CrossedPawn[3][6];
+    Score RookOnOpenFile[2];
+    Score PiecesOnOneSide[5];
+    Score MobilityBonus[PIECE_TYPE_NB][18];
+    Score QuadraticOurs[6][6];
+    Score QuadraticTheirs[6][6];
+    Score Bonus[PIECE_TYPE_NB][RANK_NB][int(FILE_NB) / 2 + 1];
+
+    // All the parameters, as one array of Score
+    const Score* data() const { return &HollowCannon; }
+    Score* data() { return &HollowCannon; }
+  };
+
+  extern Params params;
+
+  Params default_params();
+  bool load_params(const std::string& fname);
+  bool save_params(const std::string& fname, const Params& p);
+
 } // namespace Eval
 
 } // namespace Stockfish
@@ -15,10 +15,9 @@
 
 #include <iostream>
 
-#include "bitboard.h"
-#include "position.h"
-#include "search.h"
-#include "thread.h"
+#include "engine.h"
+#include "misc.h"
+#include "tune.h"
 #include "uci.h"
 
 using namespace Stockfish;
@@ -28,16 +27,11 @@ int main(int argc, char* argv[]) {
   std::cout << engine_info() << std::endl;
 
   CommandLine::init(argc, argv);
-  UCI::init(Options);
-  Tune::init();
-  PSQT::init();
-  Bitboards::init();
-  Position::init();
-  Threads.set(size_t(Options["Threads"]));
-  Search::clear(); // After threads are up
 
-  UCI::loop(argc, argv);
+  Engine engine; // Also clears the histories and the hash
+  Tune::init(engine.options);
+
+  UCI::loop(engine, argc, argv);
 
-  Threads.set(0);
   return 0;
 }
@@ -0,0 +1,417 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <climits>
+
+#include "engine.h"
+#include "mate.h"
+#include "movegen.h"
+#include "position.h"
+#include "thread.h"
+
+namespace Stockfish {
+
+using Mate::Table;
+
+namespace {
+
+  constexpr uint32_t Infinite = 1 << 30;
+
+  // Numbers are the proof and disproof numbers of a node: the least number of
+  // leaves to prove that the attacker mates, and to prove that it does not.
+  // A proven node also has the length in plies of its mate.
+  struct Numbers {
+    uint32_t pn, dn;
+    int length;
+
+    bool proven()    const { return pn == 0; }
+    bool disproven() const { return dn == 0; }
+  };
+
+  constexpr Numbers Unknown   = { 1, 1, 0 };
+  constexpr Numbers Disproven = { Infinite, 0, 0 };
+
+  constexpr Numbers proven(int length) { return { 0, Infinite, length }; }
+
+
+  // Solver holds the state of a search, the position and the attacker are
+  // those of the root.
+  class Solver {
+
+  public:
+    Solver(Position& p, Table& t) : pos(p), table(t), threads(p.this_thread()->engine.threads),
+                                    attacker(p.side_to_move()) {}
+
+    Numbers mid(uint32_t thpn, uint32_t thdn, int depth, int ply);
+    std::vector<Move> extract_pv(int length);
+    bool stopped() const { return threads.stop; }
+
+  private:
+    int generate(Move* moves) const;
+    bool judge(int ply, Numbers& n) const;
+    bool probe(Key key, int depth, Numbers& n) const;
+    void store(Key key, int depth, const Numbers& n, uint64_t work);
+    Numbers child(Move m, int depth, int ply, bool search);
+
+    Position& pos;
+    Table& table;
+    ThreadPool& threads;
+    Color attacker;
+  };
+
+
+  // Solver::generate() writes the moves of the node: the legal checks of the
+  // attacker, or all the legal replies of the defender. The checks are taken
+  // from the legal moves rather than from generate<QUIET_CHECKS>, which misses
+  // some discovered checks, while the solver needs all of them.
+
+  int Solver::generate(Move* moves) const {
+
+    bool orNode = pos.side_to_move() == attacker;
+    int count = 0;
+
+    for (const auto& m : MoveList<LEGAL>(pos))
+        if (!orNode || pos.gives_check(m))
+            moves[count++] = m;
+
+    return count;
+  }
+
+
+  // Solver::judge() tests whether the game ends by a repetition or by the 60
+  // move rule, see Position::rule_judge(). A perpetual check is a loss for the
+  // attacker, who checks at every move. The result depends on the path, so it
+  // is not stored in the table.
+
+  bool Solver::judge(int ply, Numbers& n) const {
+
+    Value result;
+
+    if (!pos.rule_judge(result, ply))
+        return false;
+
+    bool orNode = pos.side_to_move() == attacker;
+    n = (orNode ? result > VALUE_DRAW : result < VALUE_DRAW) ? proven(0) : Disproven;
+    return true;
+  }
+
+
+  // Solver::probe() reads the numbers of a position with 'depth' plies left
+  // from the table. A mate of at most 'depth' plies and a disproof with at
+  // least 'depth' plies left are valid, the other numbers only at the same
+  // depth.
+
+  bool Solver::probe(Key key, int depth, Numbers& n) const {
+
+    const Table::Entry* e = table.probe(key);
+
+    if (!e)
+        return false;
+
+    if (e->pn == 0)
+    {
+        if (e->length > depth)
+            return false;
+
+        n = proven(e->length);
+    }
+    else if (e->dn == 0)
+    {
+        if (depth > e->depth)
+            return false;
+
+        n = Disproven;
+    }
+    else
+    {
+        if (depth != e->depth)
+            return false;
+
+        n = { e->pn, e->dn, 0 };
+    }
+
+    return true;
+  }
+
+
+  void Solver::store(Key key, int depth, const Numbers& n, uint64_t work) {
+
+    Table::Entry* e = table.replace(key);
+
+    e->key = key;
+    e->pn = n.pn;
+    e->dn = n.dn;
+    e->depth = int16_t(depth);
+    e->length = uint8_t(n.length);
+    e->work = uint32_t(std::min(work, uint64_t(UINT32_MAX)));
+    e->generation = table.current_generation();
+  }
+
+
+  // Solver::mid() is the recursive df-pn search of the current position, with
+  // 'depth' plies left to mate. It returns when the proof number reaches
+  // 'thpn' or the disproof number reaches 'thdn', that is when another node
+  // becomes more promising.
+
+  Numbers Solver::mid(uint32_t thpn, uint32_t thdn, int depth, int ply) {
+
+    threads.main()->check_time();
+
+    bool orNode = pos.side_to_move() == attacker;
+    Numbers n;
+
+    if (ply && judge(ply, n))
+        return n;
+
+    Move moves[MAX_MOVES];
+    Key keys[MAX_MOVES];
+    Numbers children[MAX_MOVES];
+    int count = generate(moves);
+
+    // A side without any legal move loses, even if not in check
+    if (!count)
+        return orNode ? Disproven : proven(0);
+
+    if (!depth)
+        return Disproven;
+
+    for (int i = 0; i < count; ++i)
+        keys[i] = pos.key_after(moves[i]), children[i] = Unknown;
+
+    Key key = pos.key();
+    uint64_t nodes = pos.this_thread()->nodes;
+
+    while (true)
+    {
+        // The children may have been searched through other paths. Those that
+        // are solved stay so, a repetition is not in the table.
+        for (int i = 0; i < count; ++i)
+            if (!children[i].proven() && !children[i].disproven())
+                probe(keys[i], depth - 1, children[i]);
+
+        // An OR node (attacker to move) is proven by any of its children, an
+        // AND node by all of them. The shortest mate is kept for the attacker,
+        // the longest one for the defender.
+        int best = 0;
+        uint32_t second = Infinite;
+        n = orNode ? Numbers{ Infinite, 0, INT_MAX } : Numbers{ 0, Infinite, 0 };
+
+        for (int i = 0; i < count; ++i)
+        {
+            const Numbers& c = children[i];
+            uint32_t v = orNode ? c.pn : c.dn;
+            uint32_t bestV = orNode ? children[best].pn : children[best].dn;
+
+            if (i && v < bestV)
+                second = bestV, best = i;
+            else if (i)
+                second = std::min(second, v);
+
+            if (orNode)
+            {
+                n.pn = std::min(n.pn, c.pn);
+                n.dn = std::min(Infinite, n.dn + c.dn);
+                if (c.proven())
+                    n.length = std::min(n.length, c.length + 1);
+            }
+            else
+            {
+                n.pn = std::min(Infinite, n.pn + c.pn);
+                n.dn = std::min(n.dn, c.dn);
+                n.length = std::max(n.length, c.length + 1);
+            }
+        }
+
+        if (!n.proven())
+            n.length = 0;
+
+        if (n.pn >= thpn || n.dn >= thdn || stopped())
+            break;
+
+        const Numbers& c = children[best];
+        uint32_t childThpn = orNode ? std::min(thpn, second + 1) : thpn - n.pn + c.pn;
+        uint32_t childThdn = orNode ? thdn - n.dn + c.dn : std::min(thdn, second + 1);
+
+        StateInfo st;
+        pos.do_move(moves[best], st);
+        children[best] = mid(childThpn, childThdn, depth - 1, ply + 1);
+        pos.undo_move(moves[best]);
+    }
+
+    if (!stopped())
+        store(key, depth, n, pos.this_thread()->nodes - nodes);
+
+    return n;
+  }
+
+
+  // Solver::child() returns the numbers of the position after the move, with
+  // 'depth' plies left, from the rules or from the table. The position is
+  // searched if they are unknown and 'search' is set.
+
+  Numbers Solver::child(Move m, int depth, int ply, bool search) {
+
+    Numbers c;
+    StateInfo st;
+
+    pos.do_move(m, st);
+
+    if (!judge(ply, c) && !probe(pos.key(), depth, c))
+        c = search ? mid(Infinite, Infinite, depth, ply) : Unknown;
+
+    pos.undo_move(m);
+    return c;
+  }
+
+
+  // Solver::extract_pv() follows the proof of the root, of 'length' plies, to
+  // build the principal variation: the shortest mate known for the attacker
+  // against the reply that delays it the most. The length left decreases at
+  // every move, so the line ends even if the table is not consistent. The
+  // proofs replaced in the table are searched again. The line is empty if
+  // the search is stopped.
+
+  std::vector<Move> Solver::extract_pv(int length) {
+
+    std::vector<Move> pv;
+    std::vector<StateInfo> states(length);
+    Move moves[MAX_MOVES];
+
+    for (int ply = 0; length > 0; ++ply)
+    {
+        bool orNode = pos.side_to_move() == attacker;
+        int count = generate(moves);
+        Move best = MOVE_NONE;
+        int bestLength = 0;
+
+        // The attacker needs only one proven check, so its checks are first
+        // looked up in the table, and searched if none of them is there.
+        for (int pass = !orNode; pass < 2 && !best; ++pass)
+            for (int i = 0; i < count && !(pass && orNode && best); ++i)
+            {
+                Numbers c = child(moves[i], length - 1, ply + 1, pass);
+
+                if (stopped())
+                    break;
+
+                if (c.proven() && (!best || (orNode ? c.length < bestLength : c.length > bestLength)))
+                    best = moves[i], bestLength = c.length;
+            }
+
+        if (!best || stopped()) // The defender is mated, or the search stopped
+            break;
+
+        pv.push_back(best);
+        pos.do_move(best, states[ply]);
+        length = bestLength;
+    }
+
+    for (auto it = pv.rbegin(); it != pv.rend(); ++it)
+        pos.undo_move(*it);
+
+    if (stopped())
+        pv.clear();
+
+    return pv;
+  }
+
+} // namespace
+
+
+/// Table::clear() empties the table, which is allocated by the first call. The
+/// entries of the previous searches are only ignored, unless the generation
+/// wraps around.
+
+void Table::clear() {
+
+  if (entries.empty() || !++generation)
+      entries.assign(Clusters * ClusterSize, Entry()), generation = 1;
+}
+
+
+/// Table::probe() returns the entry of the position, nullptr if there is none
+
+Table::Entry* Table::probe(Key key) const {
+
+  Entry* cluster = &entries[(key & (Clusters - 1)) * ClusterSize];
+
+  for (size_t i = 0; i < ClusterSize; ++i)
+      if (cluster[i].key == key && cluster[i].generation == generation)
+          return &cluster[i];
+
+  return nullptr;
+}
+
+
+/// Table::replace() returns the entry to write the position to: its own one
+/// if any, otherwise an entry of a previous search, otherwise the one of its
+/// cluster on which the least work was done.
+
+Table::Entry* Table::replace(Key key) {
+
+  if (Entry* e = probe(key))
+      return e;
+
+  Entry* cluster = &entries[(key & (Clusters - 1)) * ClusterSize];
+  Entry* e = cluster;
+
+  for (size_t i = 0; i < ClusterSize; ++i)
+  {
+      if (cluster[i].generation != generation)
+          return &cluster[i];
+
+      if (cluster[i].work < e->work)
+          e = &cluster[i];
+  }
+
+  return e;
+}
+
+
+/// Mate::solve() runs the solver from the position. Once a mate is found, a
+/// shorter one is looked for until there is none, or until the search is
+/// stopped. The table is cleared first, as its disproofs may depend on the
+/// repetitions of the previous game.
+
+std::vector<Move> Mate::solve(Position& pos, int maxPly, Table& table) {
+
+  table.clear();
+
+  Solver solver(pos, table);
+  std::vector<Move> pv;
+
+  for (int depth = maxPly; depth > 0; depth = int(pv.size()) - 2)
+  {
+      Numbers n = solver.mid(Infinite, Infinite, depth, 0);
+
+      if (!n.proven())
+          break;
+
+      std::vector<Move> line = solver.extract_pv(n.length);
+
+      if (line.empty()) // Stopped
+          break;
+
+      pv = line;
+  }
+
+  return pv;
+}
+
+} // namespace Stockfish
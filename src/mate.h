@@ -0,0 +1,75 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MATE_H_INCLUDED
+#define MATE_H_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace Stockfish {
+
+class Position;
+
+/// Mate is a solver of the checking mates, where every move of the attacker
+/// gives check, as in most xiangqi mate problems. It is a depth-first proof
+/// number search (df-pn) over the checks of the side to move and all the
+/// replies of the other side, with a transposition table of its own. It is
+/// run by "go mate" before the regular search, see MainThread::search().
+
+namespace Mate {
+
+class Table {
+
+public:
+  struct Entry {
+    Key key;
+    uint32_t pn, dn;   // Proof and disproof numbers
+    uint32_t work;     // Nodes spent on the entry, for the replacement
+    int16_t depth;     // Plies left to mate when the entry was written
+    uint8_t length;    // Plies of the mate found, if proven
+    uint8_t generation;
+  };
+
+  static constexpr size_t ClusterSize = 4;
+  static constexpr size_t Clusters = size_t(1) << 18;
+
+  void clear();
+  Entry* probe(Key key) const;
+  Entry* replace(Key key);
+  uint8_t current_generation() const { return generation; }
+
+private:
+  mutable std::vector<Entry> entries;
+  uint8_t generation = 0;
+};
+
+/// solve() looks for a checking mate of the side to move in at most 'maxPly'
+/// plies. It returns the moves of the shortest checking mate, unless the search
+/// was stopped, in which case they are those of the shortest mate found so far.
+/// They are empty if there is no mate, or if none was found before the stop.
+
+std::vector<Move> solve(Position& pos, int maxPly, Table& table);
+
+} // namespace Mate
+
+} // namespace Stockfish
+
+#endif // #ifndef MATE_H_INCLUDED
@@ -32,8 +32,8 @@ namespace Stockfish::Material {
     /// standard evaluation function will be used), and scale factors.
     ///
     /// The scale factors are used to scale the evaluation score up or down. For
-    /// instance, in KRB vs KR endgames, the score is scaled down by a factor of 4,
-    /// which will result in scores of absolute value less than one pawn.
+    /// instance, in KNP vs KAABB endgames with the pawn on the last rank, the
+    /// score is scaled down by a factor of 8, as the pawn cannot help anymore.
 
     struct Entry {
 
@@ -41,9 +41,23 @@ namespace Stockfish::Material {
         Phase game_phase() const { return (Phase)gamePhase; }
         bool specialized_eval_exists() const { return evaluationFunction != nullptr; }
         Value evaluate(const Position& pos) const { return (*evaluationFunction)(pos); }
+        bool specialized_scale_exists() const { return scalingFunction[WHITE] || scalingFunction[BLACK]; }
+
+        // scale_factor() takes a position and a color as input and returns a scale factor
+        // for the given color. We have to provide the position in addition to the color
+        // because the scale factor may also be a function which should be applied to
+        // the position. For instance, in KNP vs KAABB endgames, the scale factor depends
+        // on the rank of the pawn.
+        ScaleFactor scale_factor(const Position& pos, Color c) const {
+            ScaleFactor sf = scalingFunction[c] ? (*scalingFunction[c])(pos)
+                                                : SCALE_FACTOR_NONE;
+            return sf != SCALE_FACTOR_NONE ? sf : ScaleFactor(factor[c]);
+        }
 
         Key key;
         const EndgameBase<Value>* evaluationFunction;
+        const EndgameBase<ScaleFactor>* scalingFunction[COLOR_NB]; // Could be one for each
+                                                                   // side (e.g. KNPKAB, KAABBKNP)
         Score score;
         int16_t gamePhase;
         uint8_t factor[COLOR_NB];
@@ -52,6 +66,7 @@ namespace Stockfish::Material {
     typedef HashTable<Entry, 8192> Table;
 
     Entry* probe(const Position& pos);
+    void trace(const Position& pos, int coefficients[]);
 
 } // namespace Stockfish::Material
 
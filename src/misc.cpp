@@ -53,6 +53,13 @@ typedef WORD(*fun5_t)();
 #include <sys/mman.h>
 #endif
 
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #if defined(__APPLE__) || defined(__ANDROID__) || defined(__OpenBSD__) || (defined(__GLIBCXX__) && !defined(_GLIBCXX_HAVE_ALIGNED_ALLOC) && !defined(_WIN32)) || defined(__e2k__)
 #define POSIXALIGNEDALLOC
 #include <stdlib.h>
@@ -298,23 +305,175 @@ void dbg_print() {
 }
 
 
+namespace {
+
+std::mutex ioMutex; // Serializes the writes to std::cout
+
+/// AsyncOutput writes the lines of async_cout() to std::cout from its own
+/// thread, so that a search thread never blocks on a slow GUI pipe. Producers
+/// push the lines on a lock-free stack, and only the first line of a batch
+/// wakes up the writer. The writer takes the stack whole and writes it back in
+/// push order. A PV update is dropped when the next line of the batch is
+/// another one, so a slow reader only gets the latest PV.
+
+class AsyncOutput {
+
+  struct Node {
+    Node* next;
+    std::string str;
+    bool* flushed; // Set for the markers of flush() instead of a line
+  };
+
+public:
+  AsyncOutput() : thread(&AsyncOutput::idle_loop, this) {}
+
+ ~AsyncOutput() {
+
+    { std::lock_guard<std::mutex> lk(mutex); exit = true; }
+    cv.notify_one();
+    thread.join();
+  }
+
+  void push(const std::string& str, bool* flushed = nullptr) {
+
+    Node* n = new Node{ head.load(std::memory_order_relaxed), str, flushed };
+
+    while (!head.compare_exchange_weak(n->next, n, std::memory_order_release,
+                                                   std::memory_order_relaxed)) {}
+
+    // Only a push on an empty stack wakes up the writer, the later pushes of
+    // the batch are taken with it. Taking the mutex orders the push with the
+    // check of the writer before it waits, so that the wake up cannot be lost.
+    // The writer never holds it while writing.
+    if (!n->next)
+    {
+        { std::lock_guard<std::mutex> lk(mutex); }
+        cv.notify_one();
+    }
+  }
+
+  // flush() returns once the lines pushed before the call are written
+  void flush() {
+
+    bool flushed = false;
+    push("", &flushed);
+
+    std::unique_lock<std::mutex> lk(mutex);
+    flushedCv.wait(lk, [&]{ return flushed; });
+  }
+
+private:
+  static bool is_pv(const Node* n) { return !n->flushed && n->str.compare(0, 11, "info depth ") == 0; }
+
+  void idle_loop() {
+
+    while (true)
+    {
+        Node* batch;
+
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [&]{ return exit || head.load(std::memory_order_relaxed); });
+
+            if (!(batch = head.exchange(nullptr, std::memory_order_acquire)))
+                return; // Exit only once everything is written
+        }
+
+        // Reverse the stack to get the lines in push order
+        Node* first = nullptr;
+        while (batch)
+        {
+            Node* next = batch->next;
+            batch->next = first;
+            first = batch;
+            batch = next;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(ioMutex);
+
+            for (Node* n = first; n; n = n->next)
+                if (!n->flushed && !(is_pv(n) && n->next && is_pv(n->next)))
+                    std::cout << n->str << '\n';
+
+            std::cout << std::flush;
+        }
+
+        bool anyFlushed = false;
+        while (first)
+        {
+            Node* next = first->next;
+
+            if (first->flushed)
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                *first->flushed = anyFlushed = true;
+            }
+
+            delete first;
+            first = next;
+        }
+
+        if (anyFlushed)
+            flushedCv.notify_all();
+    }
+  }
+
+  std::atomic<Node*> head{nullptr};
+  std::mutex mutex;
+  std::condition_variable cv, flushedCv;
+  bool exit = false;
+  std::thread thread; // Last member, it starts once the others are built
+};
+
+// The writer is started by the first line, and is stopped and joined after
+// the engines at exit, once all the lines are written.
+std::atomic<AsyncOutput*> asyncOutput{nullptr};
+std::once_flag asyncOnce;
+
+AsyncOutput& async_output() {
+
+  std::call_once(asyncOnce, [] {
+      static AsyncOutput out;
+      asyncOutput = &out;
+  });
+  return *asyncOutput;
+}
+
+} // namespace
+
+
 /// Used to serialize access to std::cout to avoid multiple threads writing at
-/// the same time.
+/// the same time. The lines queued by async_cout() are written first, so that
+/// for instance "readyok" always comes after the "info" lines sent before it.
 
 std::ostream& operator<<(std::ostream& os, SyncCout sc) {
 
-  static std::mutex m;
-
   if (sc == IO_LOCK)
-      m.lock();
+  {
+      if (AsyncOutput* out = asyncOutput.load(std::memory_order_acquire))
+          out->flush();
+
+      ioMutex.lock();
+  }
 
   if (sc == IO_UNLOCK)
-      m.unlock();
+      ioMutex.unlock();
 
   return os;
 }
 
 
+/// async_cout() queues a line for std::cout and returns without waiting for
+/// it to be written. The lines are written in order, after those of sync_cout
+/// already written and before those of the next sync_cout.
+
+void async_cout(const std::string& str) {
+
+  async_output().push(str);
+}
+
+
 /// Trampoline helper to avoid moving Logger to misc.h
 void start_logger(const std::string& fname) { Logger::start(fname); }
 
@@ -487,6 +646,77 @@ void aligned_large_pages_free(void *mem) {
 #endif
 
 
+/// MappedFile::open() maps the file, replacing any previous mapping. It returns
+/// false if the file cannot be mapped, empty files included.
+
+bool MappedFile::open(const std::string& fname) {
+
+  close();
+
+#if defined(_WIN32)
+
+  HANDLE fd = CreateFileA(fname.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                          OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+  if (fd == INVALID_HANDLE_VALUE)
+      return false;
+
+  LARGE_INTEGER fileSize;
+  if (GetFileSizeEx(fd, &fileSize) && fileSize.QuadPart)
+  {
+      mapping = CreateFileMapping(fd, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping)
+          mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (mem)
+          length = size_t(fileSize.QuadPart);
+  }
+
+  CloseHandle(fd);
+
+#else
+
+  int fd = ::open(fname.c_str(), O_RDONLY);
+  if (fd == -1)
+      return false;
+
+  struct stat statbuf;
+  if (!fstat(fd, &statbuf) && statbuf.st_size)
+  {
+      void* m = mmap(nullptr, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+      if (m != MAP_FAILED)
+      {
+          mem = m;
+          length = size_t(statbuf.st_size);
+      }
+  }
+
+  ::close(fd);
+
+#endif
+
+  if (!mem)
+      close();
+
+  return mem != nullptr;
+}
+
+void MappedFile::close() {
+
+#if defined(_WIN32)
+  if (mem)
+      UnmapViewOfFile(mem);
+  if (mapping)
+      CloseHandle(mapping);
+  mapping = nullptr;
+#else
+  if (mem)
+      munmap(mem, length);
+#endif
+
+  mem = nullptr;
+  length = 0;
+}
+
+
 namespace WinProcGroup {
 
 #ifndef _WIN32
@@ -19,6 +19,7 @@
 #ifndef MISC_H_INCLUDED
 #define MISC_H_INCLUDED
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <ostream>
@@ -53,7 +54,10 @@ inline TimePoint now() {
 
 template<class Entry, int Size>
 struct HashTable {
+  static constexpr size_t Bytes = Size * sizeof(Entry);
+
   Entry* operator[](Key key) { return &table[(uint32_t)key & (Size - 1)]; }
+  void clear() { std::fill(table.begin(), table.end(), Entry()); }
 
 private:
   std::vector<Entry> table = std::vector<Entry>(Size); // Allocate on the heap
@@ -74,6 +78,8 @@ std::ostream& operator<<(std::ostream&, SyncCout);
 #define sync_cout std::cout << IO_LOCK
 #define sync_endl std::endl << IO_UNLOCK
 
+void async_cout(const std::string& str);
+
 
 // align_ptr_up() : get the first aligned element of an array.
 // ptr must point to an array of size at least `sizeof(T) * N + alignment` bytes,
@@ -184,6 +190,32 @@ inline uint64_t mul_hi64(uint64_t a, uint64_t b) {
 #endif
 }
 
+/// MappedFile maps a whole file read-only in memory, so that large data files
+/// are paged in on demand and shared between the threads that read them.
+
+class MappedFile {
+
+public:
+  MappedFile() = default;
+ ~MappedFile() { close(); }
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& fname);
+  void close();
+
+  bool is_open() const { return mem != nullptr; }
+  const void* data() const { return mem; }
+  size_t size() const { return length; }
+
+private:
+  void* mem = nullptr;
+  size_t length = 0;
+#if defined(_WIN32)
+  void* mapping = nullptr;
+#endif
+};
+
 /// Under Windows it is not possible for a process to run on more than one
 /// logical processor group. This usually means to be limited to use max 64
 /// cores. To overcome this, some special platform specific API should be
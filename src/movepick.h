@@ -82,12 +82,76 @@ struct Stats<T, D, Size> : public std::array<StatsEntry<T, D>, Size> {};
 enum StatsParams { NOT_USED = 0 };
 enum StatsType { NoCaptures, Captures };
 
+/// PieceSquareIndex numbers the squares that each piece can ever stand on:
+/// advisors, bishops and kings only reach a few squares, pawns never go back.
+/// Index 0 is shared by NO_PIECE and the squares a piece cannot reach, which
+/// only appear in illegal setups.
+constexpr int PIECE_SQUARE_NB = 1 + 2 * (90 + 5 + 90 + 55 + 90 + 7 + 9);
+
+struct PieceSquareTable {
+  uint16_t index[PIECE_NB][SQUARE_NB];
+
+  static constexpr bool reachable(Piece pc, Square s) {
+    Color c = Color(pc >> 3);
+    File f = file_of(s);
+    Rank r = relative_rank(c, s);
+
+    switch (type_of(pc)) {
+    case ROOK: case CANNON: case KNIGHT:
+        return pc != NO_PIECE;
+    case ADVISOR:
+        return r <= RANK_2 && f >= FILE_D && f <= FILE_F && (f + r) % 2;
+    case BISHOP:
+        return r <= RANK_4 && f % 2 == 0 && r % 2 == 0 && (f / 2 + r / 2) % 2;
+    case KING:
+        return r <= RANK_2 && f >= FILE_D && f <= FILE_F;
+    case PAWN:
+        return r >= RANK_5 || (r >= RANK_3 && f % 2 == 0);
+    default:
+        return false;
+    }
+  }
+
+  constexpr PieceSquareTable() : index() {
+    int n = 0;
+    for (Piece pc = NO_PIECE; pc < PIECE_NB; pc = Piece(pc + 1))
+        for (Square s = SQ_A0; s < SQUARE_NB; s = Square(s + 1))
+            index[pc][s] = reachable(pc, s) ? ++n : 0;
+  }
+};
+
+constexpr PieceSquareTable PieceSquareIndex;
+
+static_assert(PieceSquareIndex.index[B_KING][SQ_I9] == 0
+           && PieceSquareIndex.index[B_KNIGHT][SQ_I9] == PIECE_SQUARE_NB - 1 - 7 - 9,
+              "Unexpected count of reachable squares");
+
+/// PieceToStats is a table of StatsEntry indexed by [piece][square], like
+/// Stats<T, D, PIECE_NB, SQUARE_NB>, but with only the entries of the squares
+/// each piece can reach, see PieceSquareIndex.
+template<typename T, int D>
+struct PieceToStats : public std::array<StatsEntry<T, D>, PIECE_SQUARE_NB> {
+
+  template<typename E>
+  struct Row {
+    E* entries;
+    const uint16_t* index;
+
+    E& operator[](Square s) const { return entries[index[s]]; }
+  };
+
+  Row<StatsEntry<T, D>> operator[](Piece pc) { return { this->data(), PieceSquareIndex.index[pc] }; }
+  Row<const StatsEntry<T, D>> operator[](Piece pc) const { return { this->data(), PieceSquareIndex.index[pc] }; }
+
+  void fill(const T& v) { std::fill(this->begin(), this->end(), v); }
+};
+
 /// ButterflyHistory records how often quiet moves have been successful or
 /// unsuccessful during the current search, and is used for reduction and move
 /// ordering decisions. It uses 2 tables (one for each color) indexed by
 /// the move's from and to squares, see www.chessprogramming.org/Butterfly_Boards
 /// (~11 elo)
-typedef Stats<int16_t, 7183, COLOR_NB, 1 << 14> ButterflyHistory;
+typedef Stats<int16_t, 7183, COLOR_NB, SQUARE_NB * SQUARE_NB> ButterflyHistory;
 
 /// CounterMoveHistory stores counter moves indexed by [piece][to] of the previous
 /// move, see www.chessprogramming.org/Countermove_Heuristic
@@ -97,13 +161,13 @@ typedef Stats<Move, NOT_USED, PIECE_NB, SQUARE_NB> CounterMoveHistory;
 typedef Stats<int16_t, 10692, PIECE_NB, SQUARE_NB, PIECE_TYPE_NB> CapturePieceToHistory;
 
 /// PieceToHistory is like ButterflyHistory but is addressed by a move's [piece][to]
-typedef Stats<int16_t, 29952, PIECE_NB, SQUARE_NB> PieceToHistory;
+typedef PieceToStats<int16_t, 29952> PieceToHistory;
 
 /// ContinuationHistory is the combined history of a given pair of moves, usually
 /// the current one given a previous one. The nested history table is based on
 /// PieceToHistory instead of ButterflyBoards.
 /// (~63 elo)
-typedef Stats<PieceToHistory, NOT_USED, PIECE_NB, SQUARE_NB> ContinuationHistory;
+typedef PieceToStats<PieceToHistory, NOT_USED> ContinuationHistory;
 
 
 /// MovePicker class is used to pick one pseudo-legal move at a time from the
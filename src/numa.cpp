@@ -0,0 +1,260 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(USE_NUMA)
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <sched.h>
+#endif
+
+#include "bitboard.h"
+#include "misc.h"
+#include "numa.h"
+#include "psqt.h"
+
+namespace Stockfish::Numa {
+
+thread_local Tables Local = { RookMagics, CannonMagics, BishopMagics, KnightMagics, KnightToMagics,
+                              &LineBB, &BetweenBB, PSQT::psq };
+
+namespace {
+
+  /// Replica is a node local copy of the tables. The attack tables are packed
+  /// in two blocks and the copied Magic entries are rebased to point into them.
+  struct Replica {
+    Magic    magics[5][SQUARE_NB];
+    std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> lineBB;
+    std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB> betweenBB;
+    Score    psq[PIECE_NB][SQUARE_NB];
+    Bitboard* attacks;
+    uint16_t* indices;
+    Tables   tables;
+  };
+
+  std::mutex mutex;
+  std::vector<std::vector<int>> nodeCpus; // Logical cpus of each node
+  std::vector<Replica*> replicas;         // One per node, built lazily
+
+  // parse_cpu_list() parses a Linux cpu list such as "0-3,8-11". The list is
+  // empty if the text is not as expected, the machine is then a single node.
+
+  std::vector<int> parse_cpu_list(const std::string& list) {
+
+    std::vector<int> cpus;
+    const char* p = list.c_str();
+
+    while (*p && *p != '\n')
+    {
+        char* end;
+        long first = std::strtol(p, &end, 10), last = first;
+
+        if (end != p && *end == '-')
+            p = end + 1, last = std::strtol(p, &end, 10);
+
+        if (end == p || first < 0 || last < first || last >= 1 << 16 || (*end && *end != ',' && *end != '\n'))
+            return {};
+
+        for (long c = first; c <= last; ++c)
+            cpus.push_back(int(c));
+
+        p = *end == ',' ? end + 1 : end;
+    }
+
+    return cpus;
+  }
+
+  // detect_nodes() reads the NUMA topology once. On systems where it is not
+  // available everything is reported as a single node.
+
+  void detect_nodes() {
+
+    static bool detected = false;
+    if (detected)
+        return;
+
+    detected = true;
+
+#if defined(__linux__) && !defined(__ANDROID__)
+    std::string online;
+    std::ifstream f("/sys/devices/system/node/online");
+    if (f && std::getline(f, online))
+        for (int n : parse_cpu_list(online))
+        {
+            std::string list;
+            std::ifstream c("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+            if (c && std::getline(c, list) && !parse_cpu_list(list).empty())
+                nodeCpus.push_back(parse_cpu_list(list));
+        }
+#endif
+
+    replicas.resize(nodeCpus.size(), nullptr);
+  }
+
+  // replicate() builds a copy of the tables. It is called by the first thread
+  // bound to a node, so that the pages are first-touched, and hence allocated,
+  // on that node.
+
+  Replica* replicate() {
+
+    const Magic* master[] = { RookMagics, CannonMagics, BishopMagics, KnightMagics, KnightToMagics };
+
+    // Number of attack sets of a square: rook and cannon tables are compact,
+    // see init_magics(), the others have one entry per occupancy index.
+    auto attack_count = [](const Magic& m) {
+        size_t size = size_t(1) << popcount(m.mask);
+        return m.indices ? size_t(*std::max_element(m.indices, m.indices + size)) + 1 : size;
+    };
+
+    size_t entries = 0, indices = 0;
+    for (const Magic* m : master)
+        for (Square s = SQ_A0; s <= SQ_I9; ++s)
+        {
+            entries += attack_count(m[s]);
+            indices += m[s].indices ? size_t(1) << popcount(m[s].mask) : 0;
+        }
+
+    Replica* r = new Replica();
+    r->attacks = static_cast<Bitboard*>(aligned_large_pages_alloc(entries * sizeof(Bitboard)));
+    r->indices = static_cast<uint16_t*>(aligned_large_pages_alloc(indices * sizeof(uint16_t)));
+
+    Bitboard* a = r->attacks;
+    uint16_t* x = r->indices;
+    for (int i = 0; i < 5; ++i)
+        for (Square s = SQ_A0; s <= SQ_I9; ++s)
+        {
+            const Magic& m = master[i][s];
+            size_t count = attack_count(m);
+
+            r->magics[i][s] = m;
+            r->magics[i][s].attacks = a;
+            std::memcpy(a, m.attacks, count * sizeof(Bitboard));
+            a += count;
+
+            if (m.indices)
+            {
+                size_t size = size_t(1) << popcount(m.mask);
+                r->magics[i][s].indices = x;
+                std::memcpy(x, m.indices, size * sizeof(uint16_t));
+                x += size;
+            }
+        }
+
+    r->lineBB = LineBB;
+    r->betweenBB = BetweenBB;
+    std::memcpy(r->psq, PSQT::psq, sizeof(PSQT::psq));
+
+    r->tables = { r->magics[0], r->magics[1], r->magics[2], r->magics[3], r->magics[4],
+                  &r->lineBB, &r->betweenBB, r->psq };
+    return r;
+  }
+
+} // namespace
+
+
+/// Numa::node_count() returns the number of NUMA nodes of the machine
+
+size_t node_count() {
+
+  std::lock_guard<std::mutex> lk(mutex);
+  detect_nodes();
+  return std::max(nodeCpus.size(), size_t(1));
+}
+
+
+/// Numa::bind_this_thread() binds the calling thread to a node, chosen round
+/// robin from its index, and points Numa::Local to that node's replica. Nothing
+/// is done on single node machines, where the global tables are already local.
+
+void bind_this_thread(size_t idx) {
+
+  std::lock_guard<std::mutex> lk(mutex);
+  detect_nodes();
+
+  if (nodeCpus.size() < 2)
+      return;
+
+  size_t node = idx % nodeCpus.size();
+
+#if defined(__linux__) && !defined(__ANDROID__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int c : nodeCpus[node])
+      if (c < CPU_SETSIZE)
+          CPU_SET(c, &set);
+
+  if (sched_setaffinity(0, sizeof(cpu_set_t), &set))
+      return;
+#endif
+
+  if (!replicas[node])
+  {
+      static bool registered = false;
+      if (!registered)
+          registered = !std::atexit(free_replicas);
+
+      replicas[node] = replicate();
+  }
+
+  Local = replicas[node]->tables;
+}
+
+
+
+/// Numa::update_psq() copies the PSQT to the replicas after it is rebuilt,
+/// when the evaluation parameters are changed.
+
+void update_psq() {
+
+  std::lock_guard<std::mutex> lk(mutex);
+
+  for (Replica* r : replicas)
+      if (r)
+          std::memcpy(r->psq, PSQT::psq, sizeof(PSQT::psq));
+}
+
+
+/// Numa::free_replicas() frees the replicas, when replication is switched off
+/// and at exit. No thread may be bound to a node anymore, a replica is built
+/// again by the next thread bound.
+
+void free_replicas() {
+
+  std::lock_guard<std::mutex> lk(mutex);
+
+  for (Replica*& r : replicas)
+      if (r)
+      {
+          aligned_large_pages_free(r->attacks);
+          aligned_large_pages_free(r->indices);
+          delete r;
+          r = nullptr;
+      }
+}
+
+} // namespace Stockfish::Numa
+
+#endif // #if defined(USE_NUMA)
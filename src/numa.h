@@ -0,0 +1,61 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NUMA_H_INCLUDED
+#define NUMA_H_INCLUDED
+
+#include <array>
+#include <cstddef>
+
+#include "types.h"
+
+namespace Stockfish {
+
+struct Magic;
+
+/// On multi-socket machines the read-mostly lookup tables (magic attack tables,
+/// LineBB/BetweenBB and the PSQT) can be replicated once per NUMA node. Every
+/// thread reads them through Numa::Local, which points to the global tables by
+/// default and to the copy on its own node once the thread has been bound.
+/// Only compiled in with -DUSE_NUMA (make numa=yes).
+
+namespace Numa {
+
+struct Tables {
+  const Magic* rookMagics;
+  const Magic* cannonMagics;
+  const Magic* bishopMagics;
+  const Magic* knightMagics;
+  const Magic* knightToMagics;
+  const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB>* lineBB;
+  const std::array<std::array<Bitboard, SQUARE_NB>, SQUARE_NB>* betweenBB;
+  const Score (*psq)[SQUARE_NB];
+};
+
+extern thread_local Tables Local;
+
+size_t node_count();
+void bind_this_thread(size_t idx);
+void update_psq();
+void free_replicas();
+
+} // namespace Stockfish::Numa
+
+} // namespace Stockfish
+
+#endif // #ifndef NUMA_H_INCLUDED
@@ -24,6 +24,7 @@
 #include <sstream>
 
 #include "bitboard.h"
+#include "engine.h"
 #include "misc.h"
 #include "position.h"
 #include "thread.h"
@@ -224,6 +225,31 @@ void Position::set_state(StateInfo* si) const {
 }
 
 
+/// Position::material_key() returns the material key of an endgame code like
+/// "KRKAABB", where the pieces before the second king belong to the strong
+/// side c. It is used to register the endgames, see Endgames::add().
+
+Key Position::material_key(const string& code, Color c) {
+
+  assert(code.length() > 1 && code[0] == 'K');
+
+  size_t weak = code.find('K', 1);
+  int count[PIECE_NB] = {};
+  Key key = 0;
+
+  assert(weak != string::npos);
+
+  for (size_t i = 0; i < code.length(); ++i)
+      ++count[make_piece(i < weak ? c : ~c, PieceType(PieceToChar.find(code[i])))];
+
+  for (Piece pc : Pieces)
+      for (int cnt = 0; cnt < count[pc]; ++cnt)
+          key ^= Zobrist::psq[pc][cnt];
+
+  return key;
+}
+
+
 /// Position::fen() returns a FEN representation of the position.
 
 string Position::fen() const {
@@ -423,7 +449,8 @@ void Position::do_move(Move m, StateInfo& newSt, bool givesCheck) {
   // Update the bloom filter
   ++filter[st->key];
 
-  thisThread->nodes.fetch_add(1, std::memory_order_relaxed);
+  if (!(++thisThread->nodes & 1023))
+      thisThread->publish_counters();
   Key k = st->key ^ Zobrist::side;
 
   // Copy some fields of the old state to our new StateInfo object except the
@@ -545,7 +572,7 @@ void Position::do_null_move(StateInfo& newSt) {
 
   st->key ^= Zobrist::side;
   ++st->rule60;
-  prefetch(TT.first_entry(key()));
+  prefetch(thisThread->engine.tt.first_entry(key()));
 
   st->pliesFromNull = 0;
 
@@ -133,8 +133,10 @@ public:
 
   // Accessing hash keys
   Key key() const;
+  Key board_key() const;
   Key key_after(Move m) const;
   Key material_key() const;
+  static Key material_key(const std::string& code, Color c);
 
   // Other properties of the position
   Color side_to_move() const;
@@ -288,6 +290,12 @@ inline Key Position::key() const {
   return adjust_key60<false>(st->key);
 }
 
+// board_key() is the key of the pieces and side to move only, without the
+// 60 move rule adjustment of key(). It identifies the positions of the book.
+inline Key Position::board_key() const {
+  return st->key;
+}
+
 inline Key Position::material_key() const {
     return st->materialKey;
 }
@@ -344,7 +352,7 @@ inline void Position::put_piece(Piece pc, Square s) {
   byColorBB[color_of(pc)] |= s;
   pieceCount[pc]++;
   pieceCount[make_piece(color_of(pc), ALL_PIECES)]++;
-  psq += PSQT::psq[pc][s];
+  psq += PSQT::score(pc, s);
 }
 
 inline void Position::remove_piece(Square s) {
@@ -356,7 +364,7 @@ inline void Position::remove_piece(Square s) {
   board[s] = NO_PIECE;
   pieceCount[pc]--;
   pieceCount[make_piece(color_of(pc), ALL_PIECES)]--;
-  psq -= PSQT::psq[pc][s];
+  psq -= PSQT::score(pc, s);
 }
 
 inline void Position::move_piece(Square from, Square to) {
@@ -368,19 +376,22 @@ inline void Position::move_piece(Square from, Square to) {
   byColorBB[color_of(pc)] ^= fromTo;
   board[from] = NO_PIECE;
   board[to] = pc;
-  psq += PSQT::psq[pc][to] - PSQT::psq[pc][from];
+  psq += PSQT::score(pc, to) - PSQT::score(pc, from);
 }
 
 inline void Position::do_move(Move m, StateInfo& newSt) {
   do_move(m, newSt, gives_check(m));
 }
 
-inline Position& Position::set(const Position& pos, StateInfo* si, Thread* th) {
+/// Position::set() copies a position and its current state for another thread.
+/// The previous states are shared, they are read-only during a search.
 
-  set(pos.fen(), si, th);
+inline Position& Position::set(const Position& pos, StateInfo* si, Thread* th) {
 
-  // Special cares for bloom filter
-  std::memcpy(&filter, &pos.filter, sizeof(BloomFilter));
+  std::memcpy(static_cast<void*>(this), &pos, sizeof(Position));
+  *si = *pos.st;
+  st = si;
+  thisThread = th;
 
   return *this;
 }
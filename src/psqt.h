@@ -23,6 +23,10 @@
 
 #include "types.h"
 
+#if defined(USE_NUMA)
+#include "numa.h"
+#endif
+
 
 namespace Stockfish::PSQT
 {
@@ -31,6 +35,15 @@ extern Score psq[PIECE_NB][SQUARE_NB];
 // Fill psqt array from a set of internally linked parameters
 void init();
 
+// Read psq, from the thread's node local copy when NUMA replication is used
+inline Score score(Piece pc, Square s) {
+#if defined(USE_NUMA)
+  return Numa::Local.psq[pc][s];
+#else
+  return psq[pc][s];
+#endif
+}
+
 } // namespace Stockfish::PSQT
 
 
@@ -23,7 +23,10 @@
 #include <iostream>
 #include <sstream>
 
+#include "bitbase.h"
+#include "engine.h"
 #include "evaluate.h"
+#include "mate.h"
 #include "misc.h"
 #include "movegen.h"
 #include "movepick.h"
@@ -160,13 +163,11 @@ const int falling_7 = 2068;
 const int falling_8 = 323;
 const int falling_9 = 1852908;
 const int timeela_1 = 400;
+const int effort_1 = 970;
+const int effort_2 = 739;
 
 namespace Stockfish {
 
-namespace Search {
-  LimitsType Limits;
-}
-
 using std::string;
 using Eval::evaluate;
 using namespace Search;
@@ -176,16 +177,19 @@ namespace {
   // Different node types, used as a template parameter
   enum NodeType { NonPV, PV, Root };
 
+  // Sizes and phases of the skip-blocks, used for distributing search depths
+  // across the helper threads when the "Helper Diversity" option asks for it
+  constexpr int SkipSize[]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+  constexpr int SkipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
   // Futility margin
   Value futility_margin(Depth d, bool improving) {
     return Value(futi_mar * (d - improving));
   }
 
-  // Reductions lookup table, initialized at startup
-  int Reductions[MAX_MOVES]; // [depth or moveNumber]
-
-  Depth reduction(bool i, Depth d, int mn, Value delta, Value rootDelta) {
-    int r = Reductions[d] * Reductions[mn];
+  // Reductions lookup table of the thread, see Search::init()
+  Depth reduction(const Thread* th, bool i, Depth d, int mn, Value delta, Value rootDelta) {
+    int r = th->reductions[d] * th->reductions[mn];
     return (r + redu_1 - int(delta) * 1024 / int(rootDelta)) / 1024 + (!i && r > redu_2);
   }
 
@@ -204,6 +208,45 @@ namespace {
     return VALUE_DRAW - 1 + Value(thisThread->nodes & 0x2);
   }
 
+  // ThreadHolding marks the node, if free, as searched by the thread when its
+  // move loop starts, and frees it when the loop ends. Only the nodes of the
+  // first plies are marked, where the threads of a Lazy SMP search are the
+  // most likely to duplicate the work of each other.
+  struct ThreadHolding {
+    ThreadHolding(Thread* thisThread, Key posKey, int ply) {
+
+       location = ply < 8 ? &thisThread->engine.threads.breadcrumbs[posKey & 1023] : nullptr;
+       otherThread = owning = false;
+
+       if (location)
+       {
+           // See if another thread already marked this location, if not mark it ourselves
+           Thread* tmp = location->thread.load(std::memory_order_relaxed);
+
+           if (tmp == nullptr)
+           {
+               location->thread.store(thisThread, std::memory_order_relaxed);
+               location->key.store(posKey, std::memory_order_relaxed);
+               owning = true;
+           }
+           else if (   tmp != thisThread
+                    && location->key.load(std::memory_order_relaxed) == posKey)
+               otherThread = true;
+       }
+    }
+
+    ~ThreadHolding() {
+       if (owning) // Free the marked location
+           location->thread.store(nullptr, std::memory_order_relaxed);
+    }
+
+    bool marked() const { return otherThread; }
+
+  private:
+    Breadcrumb* location;
+    bool otherThread, owning;
+  };
+
   // Skill structure is used to implement strength limit. If we have an uci_elo then
   // we convert it to a suitable fractional skill level using anchoring to CCRL Elo
   // (goldfish 1.13 = 2000) and a fit through Ordo derived Elo for match (TC 60+0.6)
@@ -217,7 +260,7 @@ namespace {
     }
     bool enabled() const { return level < 20.0; }
     bool time_to_pick(Depth depth) const { return depth == 1 + int(level); }
-    Move pick_best(size_t multiPV);
+    Move pick_best(PRNG& rng, const RootMoves& rootMoves, size_t multiPV);
 
     double level;
     Move best = MOVE_NONE;
@@ -267,24 +310,17 @@ namespace {
 } // namespace
 
 
-/// Search::init() is called at startup to initialize various lookup tables
-
-void Search::init() {
-
-  for (int i = 1; i < MAX_MOVES; ++i)
-      Reductions[i] = int((double(redu_3)/double(1000.0) + std::log(Threads.size()) / 2) * std::log(i));
-}
-
-
-/// Search::clear() resets search state to its initial value
-
-void Search::clear() {
+/// Search::init() initializes the thread number dependent lookup tables of
+/// a pool. It is called every time the pool is resized.
 
-  Threads.main()->wait_for_search_finished();
+void Search::init(ThreadPool& threads) {
 
-  Time.availableNodes = 0;
-  TT.clear();
-  Threads.clear();
+  for (Thread* th : threads)
+  {
+      th->reductions[0] = 0;
+      for (int i = 1; i < MAX_MOVES; ++i)
+          th->reductions[i] = int((double(redu_3)/double(1000.0) + std::log(threads.size()) / 2) * std::log(i));
+  }
 }
 
 
@@ -293,28 +329,68 @@ void Search::clear() {
 
 void MainThread::search() {
 
-  if (Limits.perft)
+  if (engine.limits.perft)
   {
-      nodes = perft<true>(rootPos, Limits.perft);
+      nodes = perft<true>(rootPos, engine.limits.perft);
       sync_cout << "\nNodes searched: " << nodes << "\n" << sync_endl;
       return;
   }
 
   Color us = rootPos.side_to_move();
-  Time.init(Limits, us, rootPos.game_ply());
-  TT.new_search();
+  engine.time.init(engine.limits, us, rootPos.game_ply(), engine.options);
+
+  // A shared hash is aged by its owner, the other engines only read the generation
+  if (!engine.shares_tt())
+      engine.tt.new_search();
+
+  bool mateSolved = false;
 
   if (rootMoves.empty())
   {
       rootMoves.emplace_back(MOVE_NONE);
-      sync_cout << "info depth 0 score "
-                << UCI::value(-VALUE_MATE)
-                << sync_endl;
+      engine.output("info depth 0 score " + UCI::value(-VALUE_MATE));
+  }
+  else if (bookMove)
+  {
+      // The reply of the book, if any, is the ponder move
+      StateInfo st;
+      rootPos.do_move(bookMove, st);
+      Move reply = engine.book.probe(rootPos, true);
+      if (reply && MoveList<LEGAL>(rootPos).contains(reply))
+          rootMoves[0].pv.push_back(reply);
+      rootPos.undo_move(bookMove);
+
+      engine.output("info string book move " + UCI::move(bookMove));
   }
   else
   {
-      Threads.start_searching(); // start non-main threads
-      Thread::search();          // main thread start searching
+      // Look for a checking mate first, which is played without a search
+      if (   engine.limits.mate
+          && engine.options["Mate Solver"]
+          && engine.limits.searchmoves.empty())
+      {
+          std::vector<Move> pv = Mate::solve(rootPos, std::min(2 * engine.limits.mate - 1, MAX_PLY - 1),
+                                                mateTable);
+
+          if (!pv.empty())
+          {
+              std::swap(rootMoves[0], *std::find(rootMoves.begin(), rootMoves.end(), pv[0]));
+              rootMoves[0].pv = pv;
+              rootMoves[0].score = rootMoves[0].uciScore = mate_in(int(pv.size()));
+              rootMoves[0].selDepth = completedDepth = int(pv.size());
+              pvIdx = 0;
+              mateSolved = true;
+              engine.output(UCI::pv(rootPos, completedDepth));
+          }
+          else if (!engine.threads.stop)
+              engine.output("info string no checking mate in " + std::to_string(engine.limits.mate));
+      }
+
+      if (!mateSolved)
+      {
+          engine.threads.start_searching(); // start non-main threads
+          Thread::search();          // main thread start searching
+      }
   }
 
   // When we reach the maximum depth, we can arrive here without a raise of
@@ -323,46 +399,67 @@ void MainThread::search() {
   // GUI sends a "stop" or "ponderhit" command. We therefore simply wait here
   // until the GUI sends one of those commands.
 
-  while (!Threads.stop && (ponder || Limits.infinite))
-  {} // Busy wait for a stop or a ponder reset
+  engine.threads.wait_for_stop(engine.limits.infinite);
 
   // Stop the threads if not already stopped (also raise the stop if
   // "ponderhit" just reset Threads.ponder).
-  Threads.stop = true;
+  engine.threads.stop = true;
 
   // Wait until all threads have finished
-  Threads.wait_for_search_finished();
+  engine.threads.wait_for_search_finished();
 
   // When playing in 'nodes as time' mode, subtract the searched nodes from
   // the available ones before exiting.
-  if (Limits.npmsec)
-      Time.availableNodes += Limits.inc[us] - Threads.nodes_searched();
+  if (engine.limits.npmsec)
+      engine.time.availableNodes += engine.limits.inc[us] - engine.threads.nodes_searched();
 
   Thread* bestThread = this;
-  Skill skill = Skill(Options["Skill Level"], Options["UCI_LimitStrength"] ? int(Options["UCI_Elo"]) : 0);
+  Skill skill = Skill(engine.options["Skill Level"], engine.options["UCI_LimitStrength"] ? int(engine.options["UCI_Elo"]) : 0);
 
-  if (   int(Options["MultiPV"]) == 1
-      && !Limits.depth
+  if (   int(engine.options["MultiPV"]) == 1
+      && !bookMove
+      && !mateSolved
+      && !engine.limits.depth
       && !skill.enabled()
       && rootMoves[0].pv[0] != MOVE_NONE)
-      bestThread = Threads.get_best_thread();
+      bestThread = engine.threads.get_best_thread();
 
-  bestPreviousScore = bestThread->rootMoves[0].score;
-  bestPreviousAverageScore = bestThread->rootMoves[0].averageScore;
+  // A book move has no score, the next search starts like the first one
+  bestPreviousScore = bookMove ? VALUE_INFINITE : bestThread->rootMoves[0].score;
+  bestPreviousAverageScore = bookMove ? VALUE_INFINITE : bestThread->rootMoves[0].averageScore;
 
-  for (Thread* th : Threads)
+  for (Thread* th : engine.threads)
     th->previousDepth = bestThread->completedDepth;
 
-  // Send again PV info if we have a new best thread
-  if (bestThread != this)
-      sync_cout << UCI::pv(bestThread->rootPos, bestThread->completedDepth) << sync_endl;
+  // Send again PV info if we have a new best thread or the last one was skipped
+  if (bestThread != this || pvPending)
+      engine.output(UCI::pv(bestThread->rootPos, bestThread->completedDepth));
+
+  // Send the nodes spent on every root move by all the threads, best move first
+  string nodesInfo;
+
+  for (const RootMove& rm : bestThread->rootMoves)
+      if (uint64_t n = rm.pv[0] ? engine.threads.root_move_nodes(rm.pv[0]) : 0)
+          nodesInfo += " " + UCI::move(rm.pv[0]) + " " + std::to_string(n);
 
-  sync_cout << "bestmove " << UCI::move(bestThread->rootMoves[0].pv[0]);
+  if (!nodesInfo.empty())
+      engine.output("info string root move nodes" + nodesInfo);
 
-  if (bestThread->rootMoves[0].pv.size() > 1 || bestThread->rootMoves[0].extract_ponder_from_tt(rootPos))
-      std::cout << " ponder " << UCI::move(bestThread->rootMoves[0].pv[1]);
+  RootMove& best = bestThread->rootMoves[0];
+  bool hasPonder = best.pv.size() > 1 || best.extract_ponder_from_tt(rootPos);
 
-  std::cout << sync_endl;
+  // Publish the result for the library API before the "bestmove" line, so
+  // that anyone woken up by it sees the final values.
+  engine.result.bestMove   = best.pv[0];
+  engine.result.ponderMove = hasPonder ? best.pv[1] : MOVE_NONE;
+  engine.result.score      =  best.pv[0] == MOVE_NONE ? -VALUE_MATE
+                             : bookMove              ? VALUE_NONE : best.uciScore;
+  engine.result.depth      = bestThread->completedDepth;
+  engine.result.nodes      = engine.threads.nodes_searched();
+  engine.result.pv         = best.pv;
+
+  engine.output("bestmove " + UCI::move(best.pv[0])
+                + (hasPonder ? " ponder " + UCI::move(best.pv[1]) : ""));
 }
 
 
@@ -381,7 +478,7 @@ void Thread::search() {
   Value alpha, beta, delta;
   Move  lastBestMove = MOVE_NONE;
   Depth lastBestMoveDepth = 0;
-  MainThread* mainThread = (this == Threads.main() ? Threads.main() : nullptr);
+  MainThread* mainThread = (this == engine.threads.main() ? engine.threads.main() : nullptr);
   double timeReduction = 1, totBestMoveChanges = 0;
   Color us = rootPos.side_to_move();
   int iterIdx = 0;
@@ -389,7 +486,7 @@ void Thread::search() {
   std::memset(ss-7, 0, 10 * sizeof(Stack));
   for (int i = 7; i > 0; i--)
   {
-      (ss-i)->continuationHistory = &this->continuationHistory[0][0][NO_PIECE][0]; // Use as a sentinel
+      (ss-i)->continuationHistory = &histories->continuationHistory[0][0][NO_PIECE][SQ_A0]; // Use as a sentinel
       (ss - i)->staticEval = VALUE_NONE;
   }
 
@@ -411,8 +508,8 @@ void Thread::search() {
               mainThread->iterValue[i] = mainThread->bestPreviousScore;
   }
 
-  size_t multiPV = size_t(Options["MultiPV"]);
-  Skill skill(Options["Skill Level"], Options["UCI_LimitStrength"] ? int(Options["UCI_Elo"]) : 0);
+  size_t multiPV = size_t(engine.options["MultiPV"]);
+  Skill skill(engine.options["Skill Level"], engine.options["UCI_LimitStrength"] ? int(engine.options["UCI_Elo"]) : 0);
 
   // When playing with strength handicap enable MultiPV search that we will
   // use behind the scenes to retrieve a set of possible moves.
@@ -421,6 +518,12 @@ void Thread::search() {
 
   multiPV = std::min(multiPV, rootMoves.size());
 
+  // The helpers may skip some depths or widen their aspiration windows, so
+  // that they search differently from the main thread and from each other.
+  const UCI::Option& diversity = engine.options["Helper Diversity"];
+  bool skipDepths  = idx && (diversity == "Depth"  || diversity == "Both");
+  bool wideWindows = idx && (diversity == "Window" || diversity == "Both");
+
   complexityAverage.set(comp_1, 1);
 
   optimism[us] = optimism[~us] = VALUE_ZERO;
@@ -429,9 +532,17 @@ void Thread::search() {
 
   // Iterative deepening loop until requested to stop or the target depth is reached
   while (   ++rootDepth < MAX_PLY
-         && !Threads.stop
-         && !(Limits.depth && mainThread && rootDepth > Limits.depth))
+         && !engine.threads.stop
+         && !(engine.limits.depth && mainThread && rootDepth > engine.limits.depth))
   {
+      // Distribute search depths across the helper threads
+      if (skipDepths)
+      {
+          int i = (idx - 1) % 20;
+          if (((rootDepth + SkipPhase[i]) / SkipSize[i]) % 2)
+              continue;  // Retry with an incremented rootDepth
+      }
+
       // Age out PV variability metric
       if (mainThread)
           totBestMoveChanges /= 2;
@@ -444,11 +555,11 @@ void Thread::search() {
       size_t pvFirst = 0;
       pvLast = rootMoves.size();
 
-      if (!Threads.increaseDepth)
+      if (!engine.threads.increaseDepth)
          searchAgainCounter++;
 
       // MultiPV loop. We perform a full root search for each PV line
-      for (pvIdx = 0; pvIdx < multiPV && !Threads.stop; ++pvIdx)
+      for (pvIdx = 0; pvIdx < multiPV && !engine.threads.stop; ++pvIdx)
       {
           // Reset UCI info selDepth for each depth and each PV line
           selDepth = 0;
@@ -458,6 +569,11 @@ void Thread::search() {
           {
               Value prev = rootMoves[pvIdx].averageScore;
               delta = Value(delt_1) + int(prev) * prev / delt_2;
+
+              // Helpers start with a window up to twice as wide
+              if (wideWindows)
+                  delta += delta * int(idx % 5) / 4;
+
               alpha = std::max(prev - delta,-VALUE_INFINITE);
               beta  = std::min(prev + delta, VALUE_INFINITE);
 
@@ -493,7 +609,7 @@ void Thread::search() {
               // If search has been stopped, we break immediately. Sorting is
               // safe because RootMoves is still valid, although it refers to
               // the previous iteration.
-              if (Threads.stop)
+              if (engine.threads.stop)
                   break;
 
               // When failing high/low give some update (without cluttering
@@ -501,8 +617,12 @@ void Thread::search() {
               if (   mainThread
                   && multiPV == 1
                   && (bestValue <= alpha || bestValue >= beta)
-                  && Time.elapsed() > 3000)
-                  sync_cout << UCI::pv(rootPos, rootDepth) << sync_endl;
+                  && engine.time.elapsed() > 3000
+                  && engine.time.elapsed() >= mainThread->nextPvTime)
+              {
+                  engine.output(UCI::pv(rootPos, rootDepth));
+                  mainThread->nextPvTime = engine.time.elapsed() + int(engine.options["Info Interval"]);
+              }
 
               // In case of failing low/high increase aspiration window and
               // re-search, otherwise exit the loop.
@@ -531,12 +651,23 @@ void Thread::search() {
           // Sort the PV lines searched so far and update the GUI
           std::stable_sort(rootMoves.begin() + pvFirst, rootMoves.begin() + pvIdx + 1);
 
+          // Updates closer than the "Info Interval" option are skipped, the
+          // last one is then sent before "bestmove".
           if (    mainThread
-              && (Threads.stop || pvIdx + 1 == multiPV || Time.elapsed() > 3000))
-              sync_cout << UCI::pv(rootPos, rootDepth) << sync_endl;
+              && (engine.threads.stop || pvIdx + 1 == multiPV || engine.time.elapsed() > 3000))
+          {
+              mainThread->pvPending =   !engine.threads.stop
+                                     && engine.time.elapsed() < mainThread->nextPvTime;
+
+              if (!mainThread->pvPending)
+              {
+                  engine.output(UCI::pv(rootPos, rootDepth));
+                  mainThread->nextPvTime = engine.time.elapsed() + int(engine.options["Info Interval"]);
+              }
+          }
       }
 
-      if (!Threads.stop)
+      if (!engine.threads.stop)
           completedDepth = rootDepth;
 
       if (rootMoves[0].pv[0] != lastBestMove) {
@@ -545,28 +676,28 @@ void Thread::search() {
       }
 
       // Have we found a "mate in x"?
-      if (   Limits.mate
+      if (   engine.limits.mate
           && bestValue >= VALUE_MATE_IN_MAX_PLY
-          && VALUE_MATE - bestValue <= 2 * Limits.mate)
-          Threads.stop = true;
+          && VALUE_MATE - bestValue <= 2 * engine.limits.mate)
+          engine.threads.stop_searching(); // Helpers may find it after main has finished
 
       if (!mainThread)
           continue;
 
       // If skill level is enabled and time is up, pick a sub-optimal best move
       if (skill.enabled() && skill.time_to_pick(rootDepth))
-          skill.pick_best(multiPV);
+          skill.pick_best(mainThread->rng, rootMoves, multiPV);
 
       // Use part of the gained time from a previous stable move for the current move
-      for (Thread* th : Threads)
+      for (Thread* th : engine.threads)
       {
           totBestMoveChanges += th->bestMoveChanges;
           th->bestMoveChanges = 0;
       }
 
       // Do we have time for the next iteration? Can we stop searching now?
-      if (    Limits.use_time_management()
-          && !Threads.stop
+      if (    engine.limits.use_time_management()
+          && !engine.threads.stop
           && !mainThread->stopOnPonderhit)
       {
           double fallingEval = (falling_1 + 12 * (mainThread->bestPreviousAverageScore - bestValue)
@@ -576,33 +707,46 @@ void Thread::search() {
           // If the bestMove is stable over several iterations, reduce time accordingly
           timeReduction = lastBestMoveDepth + falling_3 < completedDepth ? (double(falling_4)/double(1000.0)) : (double(falling_5)/double(1000.0));
           double reduction = ((double(falling_6)/double(1000.0)) + mainThread->previousTimeReduction) / ((double(falling_7)/double(1000.0)) * timeReduction);
-          double bestMoveInstability = 1 + 1.7 * totBestMoveChanges / Threads.size();
+          double bestMoveInstability = 1 + 1.7 * totBestMoveChanges / engine.threads.size();
           int complexity = mainThread->complexityAverage.value();
           double complexPosition = std::min(1.0 + (complexity - falling_8) / (double(falling_9)/double(1000.0)), 1.5);
 
-          double totalTime = Time.optimum() * fallingEval * reduction * bestMoveInstability * complexPosition;
-
-          // Stop the search if we have exceeded the totalTime or in case of a single legal move
-          if (Time.elapsed() > totalTime || rootMoves.size() == 1)
+          double totalTime = engine.time.optimum() * fallingEval * reduction * bestMoveInstability * complexPosition;
+
+          // Share of the nodes of all the threads spent on the best move. When
+          // it is most of them, the other moves were refuted quickly and the
+          // best move is unlikely to change.
+          double bestMoveEffort =  double(engine.threads.root_move_nodes(rootMoves[0].pv[0]))
+                                 / std::max(engine.threads.nodes_searched(), uint64_t(1));
+
+          // Stop the search if we have exceeded the totalTime, in case of a single
+          // legal move, or a bit earlier if the best move took nearly all the nodes.
+          if (   engine.time.elapsed() > totalTime
+              || rootMoves.size() == 1
+              || (   completedDepth >= 10
+                  && bestMoveEffort >= (double(effort_1)/double(1000.0))
+                  && engine.time.elapsed() > totalTime * (double(effort_2)/double(1000.0))))
           {
               // If we are allowed to ponder do not stop the search now but
               // keep pondering until the GUI sends "ponderhit" or "stop".
               if (mainThread->ponder)
                   mainThread->stopOnPonderhit = true;
               else
-                  Threads.stop = true;
+                  engine.threads.stop = true;
           }
           else if ( !mainThread->ponder
-                   && Time.elapsed() > totalTime * (double(timeela_1)/double(1000.0)))
-                Threads.increaseDepth = false;
+                   && engine.time.elapsed() > totalTime * (double(timeela_1)/double(1000.0)))
+                engine.threads.increaseDepth = false;
           else
-                Threads.increaseDepth = true;
+                engine.threads.increaseDepth = true;
       }
 
       mainThread->iterValue[iterIdx] = bestValue;
       iterIdx = (iterIdx + 1) & 3;
   }
 
+  publish_counters(); // The final counts, for the result and "bestmove"
+
   if (!mainThread)
       return;
 
@@ -611,7 +755,7 @@ void Thread::search() {
   // If skill level is enabled, swap best PV line with the sub-optimal one
   if (skill.enabled())
       std::swap(rootMoves[0], *std::find(rootMoves.begin(), rootMoves.end(),
-                skill.best ? skill.best : skill.pick_best(multiPV)));
+                skill.best ? skill.best : skill.pick_best(mainThread->rng, rootMoves, multiPV)));
 }
 
 
@@ -650,6 +794,7 @@ namespace {
 
     // Step 1. Initialize node
     Thread* thisThread = pos.this_thread();
+    TranspositionTable& tt = thisThread->engine.tt;
     ss->inCheck        = pos.checkers();
     priorCapture       = pos.captured_piece();
     Color us           = pos.side_to_move();
@@ -658,7 +803,7 @@ namespace {
     maxValue           = VALUE_INFINITE;
 
     // Check for the available remaining time
-    if (thisThread == Threads.main())
+    if (thisThread == thisThread->engine.threads.main())
         static_cast<MainThread*>(thisThread)->check_time();
 
     // Used to send selDepth info to GUI (selDepth counts from 1, ply from 0)
@@ -672,7 +817,7 @@ namespace {
         if (pos.rule_judge(result, ss->ply))
             return result == VALUE_DRAW ? value_draw(pos.this_thread()) : result;
 
-        if (Threads.stop.load(std::memory_order_relaxed) || ss->ply >= MAX_PLY)
+        if (thisThread->engine.threads.stop.load(std::memory_order_relaxed) || ss->ply >= MAX_PLY)
             return (ss->ply >= MAX_PLY && !ss->inCheck) ? evaluate(pos) : value_draw(pos.this_thread());
 
         // Step 3. Mate distance pruning. Even if we mate at the next move our score
@@ -711,7 +856,7 @@ namespace {
     // position key in case of an excluded move.
     excludedMove = ss->excludedMove;
     posKey = excludedMove == MOVE_NONE ? pos.key() : pos.key() ^ make_key(excludedMove);
-    tte = TT.probe(posKey, ss->ttHit);
+    tte = tt.probe(posKey, ss->ttHit);
     ttValue = ss->ttHit ? value_from_tt(tte->value(), ss->ply, pos.rule60_count()) : VALUE_NONE;
     ttMove =  rootNode ? thisThread->rootMoves[thisThread->pvIdx].pv[0]
             : ss->ttHit    ? tte->move() : MOVE_NONE;
@@ -743,7 +888,7 @@ namespace {
             else if (!ttCapture)
             {
                 int penalty = -stat_bonus(depth);
-                thisThread->mainHistory[us][from_to(ttMove)] << penalty;
+                thisThread->histories->mainHistory[us][from_to(ttMove)] << penalty;
                 update_continuation_histories(ss, pos.moved_piece(ttMove), to_sq(ttMove), penalty);
             }
         }
@@ -754,7 +899,47 @@ namespace {
             return ttValue;
     }
 
-    CapturePieceToHistory& captureHistory = thisThread->captureHistory;
+    // Bitbase probe. The bitbases ignore the 60 move rule, so they are only
+    // probed when its count is reset, after the capture into the endgame.
+    if (   !rootNode
+        && !excludedMove
+        && pos.count<ALL_PIECES>() <= Bitbases::MaxCardinality
+        && pos.rule60_count() == 0)
+    {
+        Bitbases::WDLScore wdl;
+
+        if (Bitbases::probe(pos, wdl))
+        {
+            ++thisThread->tbHits;
+
+            value =  wdl == Bitbases::WDL_LOSS ? VALUE_MATED_IN_MAX_PLY + ss->ply + 1
+                   : wdl == Bitbases::WDL_WIN  ? VALUE_MATE_IN_MAX_PLY  - ss->ply - 1
+                                               : VALUE_DRAW;
+
+            Bound b =  wdl == Bitbases::WDL_LOSS ? BOUND_UPPER
+                     : wdl == Bitbases::WDL_WIN  ? BOUND_LOWER : BOUND_EXACT;
+
+            if (    b == BOUND_EXACT
+                || (b == BOUND_LOWER ? value >= beta : value <= alpha))
+            {
+                tte->save(posKey, value_to_tt(value, ss->ply), ss->ttPv, b,
+                          std::min(MAX_PLY - 1, depth + 6),
+                          MOVE_NONE, VALUE_NONE, tt.generation());
+
+                return value;
+            }
+
+            if (PvNode)
+            {
+                if (b == BOUND_LOWER)
+                    bestValue = value, alpha = std::max(alpha, bestValue);
+                else
+                    maxValue = value;
+            }
+        }
+    }
+
+    CapturePieceToHistory& captureHistory = thisThread->histories->captureHistory;
 
     // Step 5. Static evaluation of the position
     if (ss->inCheck)
@@ -786,7 +971,7 @@ namespace {
 
         // Save static evaluation into transposition table
         if (!excludedMove)
-            tte->save(posKey, VALUE_NONE, ss->ttPv, BOUND_NONE, DEPTH_NONE, MOVE_NONE, eval);
+            tte->save(posKey, VALUE_NONE, ss->ttPv, BOUND_NONE, DEPTH_NONE, MOVE_NONE, eval, tt.generation());
     }
 
     thisThread->complexityAverage.update(complexity);
@@ -795,7 +980,7 @@ namespace {
     if (is_ok((ss-1)->currentMove) && !(ss-1)->inCheck && !priorCapture)
     {
         int bonus = std::clamp(-16 * int((ss-1)->staticEval + ss->staticEval), -2000, 2000);
-        thisThread->mainHistory[~us][from_to((ss-1)->currentMove)] << bonus;
+        thisThread->histories->mainHistory[~us][from_to((ss-1)->currentMove)] << bonus;
     }
 
     // Set up the improvement variable, which is the difference between the current
@@ -843,7 +1028,7 @@ namespace {
         Depth R = std::min(int(eval - beta) / Numov_5, Numov_6) + depth / 3 + 4 - (complexity > Numov_9);
 
         ss->currentMove = MOVE_NULL;
-        ss->continuationHistory = &thisThread->continuationHistory[0][0][NO_PIECE][0];
+        ss->continuationHistory = &thisThread->histories->continuationHistory[0][0][NO_PIECE][SQ_A0];
 
         pos.do_null_move(st);
 
@@ -903,10 +1088,10 @@ namespace {
                 assert(pos.capture(move));
 
                 ss->currentMove = move;
-                ss->continuationHistory = &thisThread->continuationHistory[ss->inCheck]
-                                                                          [true]
-                                                                          [pos.moved_piece(move)]
-                                                                          [to_sq(move)];
+                ss->continuationHistory = &thisThread->histories->continuationHistory[ss->inCheck]
+                                                                                     [true]
+                                                                                     [pos.moved_piece(move)]
+                                                                                     [to_sq(move)];
 
                 pos.do_move(move, st);
 
@@ -922,7 +1107,7 @@ namespace {
                 if (value >= probCutBeta)
                 {
                     // Save ProbCut data into transposition table
-                    tte->save(posKey, value_to_tt(value, ss->ply), ss->ttPv, BOUND_LOWER, depth - 3, move, ss->staticEval);
+                    tte->save(posKey, value_to_tt(value, ss->ply), ss->ttPv, BOUND_LOWER, depth - 3, move, ss->staticEval, tt.generation());
                     return value;
                 }
             }
@@ -968,9 +1153,9 @@ moves_loop: // When in check, search starts here
                                           nullptr                   , (ss-4)->continuationHistory,
                                           nullptr                   , (ss-6)->continuationHistory };
 
-    Move countermove = thisThread->counterMoves[pos.piece_on(prevSq)][prevSq];
+    Move countermove = thisThread->histories->counterMoves[pos.piece_on(prevSq)][prevSq];
 
-    MovePicker mp(pos, ttMove, depth, &thisThread->mainHistory,
+    MovePicker mp(pos, ttMove, depth, &thisThread->histories->mainHistory,
                                       &captureHistory,
                                       contHist,
                                       countermove,
@@ -979,6 +1164,9 @@ moves_loop: // When in check, search starts here
     value = bestValue;
     moveCountPruning = singularQuietLMR = false;
 
+    // Mark this node as being searched
+    ThreadHolding th(thisThread, posKey, ss->ply);
+
     // Indicate PvNodes that will probably fail low if the node was searched
     // at a depth equal or greater than the current depth, and the result of this search was a fail low.
     bool likelyFailLow =    PvNode
@@ -1030,7 +1218,7 @@ moves_loop: // When in check, search starts here
           moveCountPruning = moveCount >= futility_move_count(improving, depth);
 
           // Reduced depth of the next LMR search
-          int lmrDepth = std::max(newDepth - reduction(improving, depth, moveCount, delta, thisThread->rootDelta), 0);
+          int lmrDepth = std::max(newDepth - reduction(thisThread, improving, depth, moveCount, delta, thisThread->rootDelta), 0);
 
           if (   capture
               || givesCheck)
@@ -1059,7 +1247,7 @@ moves_loop: // When in check, search starts here
                   && history < -Futi_cap_7 * (depth - 1))
                   continue;
 
-              history += 2 * thisThread->mainHistory[us][from_to(move)];
+              history += 2 * thisThread->histories->mainHistory[us][from_to(move)];
 
               // Futility pruning: parent node (~9 Elo)
               if (   !ss->inCheck
@@ -1078,7 +1266,7 @@ moves_loop: // When in check, search starts here
       }
 
       // Speculative prefetch as early as possible
-      prefetch(TT.first_entry(pos.key_after(move)));
+      prefetch(tt.first_entry(pos.key_after(move)));
 
       // Step 14. Extensions (~66 Elo)
       // We take care to not overdo to avoid search getting stuck.
@@ -1156,12 +1344,13 @@ moves_loop: // When in check, search starts here
 
       // Update the current move (this must be done after singular extension search)
       ss->currentMove = move;
-      ss->continuationHistory = &thisThread->continuationHistory[ss->inCheck]
-                                                                [capture]
-                                                                [movedPiece]
-                                                                [to_sq(move)];
+      ss->continuationHistory = &thisThread->histories->continuationHistory[ss->inCheck]
+                                                                           [capture]
+                                                                           [movedPiece]
+                                                                           [to_sq(move)];
 
       // Step 15. Make the move
+      uint64_t nodeCount = rootNode ? thisThread->nodes : 0;
       pos.do_move(move, st, givesCheck);
 
       // Step 16. Late moves reduction / extension (LMR, ~98 Elo)
@@ -1174,7 +1363,7 @@ moves_loop: // When in check, search starts here
               || !capture
               || (cutNode && (ss-1)->moveCount > 1)))
       {
-          Depth r = reduction(improving, depth, moveCount, delta, thisThread->rootDelta);
+          Depth r = reduction(thisThread, improving, depth, moveCount, delta, thisThread->rootDelta);
 
           // Decrease reduction if position is or has been on the PV
           // and node is not likely to fail low. (~3 Elo)
@@ -1186,6 +1375,10 @@ moves_loop: // When in check, search starts here
           if ((ss-1)->moveCount > decr_10)
               r -= decr_11;
 
+          // Increase reduction if another thread is searching this node
+          if (th.marked())
+              r++;
+
           // Increase reduction for cut nodes (~3 Elo)
           if (cutNode)
               r += cutredu_1 + cutredu_2 / (cutredu_3 + depth);
@@ -1206,7 +1399,7 @@ moves_loop: // When in check, search starts here
           if ((ss+1)->cutoffCnt > decr_14 && !PvNode)
               r += decr_15;
 
-          ss->statScore =  2 * thisThread->mainHistory[us][from_to(move)]
+          ss->statScore =  2 * thisThread->histories->mainHistory[us][from_to(move)]
                          + (*contHist[0])[movedPiece][to_sq(move)]
                          + (*contHist[1])[movedPiece][to_sq(move)]
                          + (*contHist[3])[movedPiece][to_sq(move)]
@@ -1265,13 +1458,18 @@ moves_loop: // When in check, search starts here
       // Step 18. Undo move
       pos.undo_move(move);
 
+      // Count the nodes of the move for the time management, even if stopped
+      if (rootNode)
+          thisThread->engine.threads.rootMoveNodes[from_to(move)].fetch_add(thisThread->nodes - nodeCount,
+                                                                             std::memory_order_relaxed);
+
       assert(value > -VALUE_INFINITE && value < VALUE_INFINITE);
 
       // Step 19. Check for a new best move
       // Finished searching the move. If a stop occurred, the return value of
       // the search cannot be trusted, and we return immediately without
       // updating best move, PV and TT.
-      if (Threads.stop.load(std::memory_order_relaxed))
+      if (thisThread->engine.threads.stop.load(std::memory_order_relaxed))
           return VALUE_ZERO;
 
       if (rootNode)
@@ -1368,7 +1566,7 @@ moves_loop: // When in check, search starts here
     // completed. But in this case bestValue is valid because we have fully
     // searched our subtree, and we can anyhow save the result in TT.
     /*
-       if (Threads.stop)
+       if (thisThread->engine.threads.stop)
         return VALUE_DRAW;
     */
 
@@ -1412,7 +1610,7 @@ moves_loop: // When in check, search starts here
         tte->save(posKey, value_to_tt(bestValue, ss->ply), ss->ttPv,
                   bestValue >= beta ? BOUND_LOWER :
                   PvNode && bestMove ? BOUND_EXACT : BOUND_UPPER,
-                  depth, bestMove, ss->staticEval);
+                  depth, bestMove, ss->staticEval, tt.generation());
 
     assert(bestValue > -VALUE_INFINITE && bestValue < VALUE_INFINITE);
 
@@ -1451,6 +1649,7 @@ moves_loop: // When in check, search starts here
     }
 
     Thread* thisThread = pos.this_thread();
+    TranspositionTable& tt = thisThread->engine.tt;
     bestMove = MOVE_NONE;
     ss->inCheck = pos.checkers();
     moveCount = 0;
@@ -1472,7 +1671,7 @@ moves_loop: // When in check, search starts here
                                                   : DEPTH_QS_NO_CHECKS;
     // Transposition table lookup
     posKey = pos.key();
-    tte = TT.probe(posKey, ss->ttHit);
+    tte = tt.probe(posKey, ss->ttHit);
     ttValue = ss->ttHit ? value_from_tt(tte->value(), ss->ply, pos.rule60_count()) : VALUE_NONE;
     ttMove = ss->ttHit ? tte->move() : MOVE_NONE;
     pvHit = ss->ttHit && tte->is_pv();
@@ -1484,6 +1683,33 @@ moves_loop: // When in check, search starts here
         && (tte->bound() & (ttValue >= beta ? BOUND_LOWER : BOUND_UPPER)))
         return ttValue;
 
+    // Bitbase probe, see search(). Only a cutoff is used here.
+    if (   pos.count<ALL_PIECES>() <= Bitbases::MaxCardinality
+        && pos.rule60_count() == 0)
+    {
+        Bitbases::WDLScore wdl;
+
+        if (Bitbases::probe(pos, wdl))
+        {
+            ++thisThread->tbHits;
+
+            value =  wdl == Bitbases::WDL_LOSS ? VALUE_MATED_IN_MAX_PLY + ss->ply + 1
+                   : wdl == Bitbases::WDL_WIN  ? VALUE_MATE_IN_MAX_PLY  - ss->ply - 1
+                                               : VALUE_DRAW;
+
+            if (    wdl == Bitbases::WDL_DRAW
+                || (wdl == Bitbases::WDL_WIN ? value >= beta : value <= alpha))
+            {
+                tte->save(posKey, value_to_tt(value, ss->ply), pvHit,
+                          wdl == Bitbases::WDL_DRAW ? BOUND_EXACT
+                        : wdl == Bitbases::WDL_WIN  ? BOUND_LOWER : BOUND_UPPER,
+                          ttDepth, MOVE_NONE, VALUE_NONE, tt.generation());
+
+                return value;
+            }
+        }
+    }
+
     // Evaluate the position statically
     if (ss->inCheck)
     {
@@ -1515,7 +1741,7 @@ moves_loop: // When in check, search starts here
             // Save gathered info in transposition table
             if (!ss->ttHit)
                 tte->save(posKey, value_to_tt(bestValue, ss->ply), false, BOUND_LOWER,
-                          DEPTH_NONE, MOVE_NONE, ss->staticEval);
+                          DEPTH_NONE, MOVE_NONE, ss->staticEval, tt.generation());
 
             return bestValue;
         }
@@ -1534,8 +1760,8 @@ moves_loop: // When in check, search starts here
     // to search the moves. Because the depth is <= 0 here, only captures
     // and other checks (only if depth >= DEPTH_QS_CHECKS) will be generated.
     Square prevSq = to_sq((ss-1)->currentMove);
-    MovePicker mp(pos, ttMove, depth, &thisThread->mainHistory,
-                                      &thisThread->captureHistory,
+    MovePicker mp(pos, ttMove, depth, &thisThread->histories->mainHistory,
+                                      &thisThread->histories->captureHistory,
                                       contHist,
                                       prevSq);
 
@@ -1586,13 +1812,13 @@ moves_loop: // When in check, search starts here
           continue;
 
       // Speculative prefetch as early as possible
-      prefetch(TT.first_entry(pos.key_after(move)));
+      prefetch(tt.first_entry(pos.key_after(move)));
 
       ss->currentMove = move;
-      ss->continuationHistory = &thisThread->continuationHistory[ss->inCheck]
-                                                                [capture]
-                                                                [pos.moved_piece(move)]
-                                                                [to_sq(move)];
+      ss->continuationHistory = &thisThread->histories->continuationHistory[ss->inCheck]
+                                                                           [capture]
+                                                                           [pos.moved_piece(move)]
+                                                                           [to_sq(move)];
 
       // Continuation history based pruning (~2 Elo)
       if (   !capture
@@ -1648,7 +1874,7 @@ moves_loop: // When in check, search starts here
     // Save gathered info in transposition table
     tte->save(posKey, value_to_tt(bestValue, ss->ply), pvHit,
               bestValue >= beta ? BOUND_LOWER : BOUND_UPPER,
-              ttDepth, bestMove, ss->staticEval);
+              ttDepth, bestMove, ss->staticEval, tt.generation());
 
     assert(bestValue > -VALUE_INFINITE && bestValue < VALUE_INFINITE);
 
@@ -1707,7 +1933,7 @@ moves_loop: // When in check, search starts here
 
     Color us = pos.side_to_move();
     Thread* thisThread = pos.this_thread();
-    CapturePieceToHistory& captureHistory = thisThread->captureHistory;
+    CapturePieceToHistory& captureHistory = thisThread->histories->captureHistory;
     Piece moved_piece = pos.moved_piece(bestMove);
     PieceType captured = type_of(pos.piece_on(to_sq(bestMove)));
     int bonus1 = stat_bonus(depth + 1);
@@ -1723,7 +1949,7 @@ moves_loop: // When in check, search starts here
         // Decrease stats for all non-best quiet moves
         for (int i = 0; i < quietCount; ++i)
         {
-            thisThread->mainHistory[us][from_to(quietsSearched[i])] << -bonus2;
+            thisThread->histories->mainHistory[us][from_to(quietsSearched[i])] << -bonus2;
             update_continuation_histories(ss, pos.moved_piece(quietsSearched[i]), to_sq(quietsSearched[i]), -bonus2);
         }
     }
@@ -1776,24 +2002,21 @@ moves_loop: // When in check, search starts here
 
     Color us = pos.side_to_move();
     Thread* thisThread = pos.this_thread();
-    thisThread->mainHistory[us][from_to(move)] << bonus;
+    thisThread->histories->mainHistory[us][from_to(move)] << bonus;
     update_continuation_histories(ss, pos.moved_piece(move), to_sq(move), bonus);
 
     // Update countermove history
     if (is_ok((ss-1)->currentMove))
     {
         Square prevSq = to_sq((ss-1)->currentMove);
-        thisThread->counterMoves[pos.piece_on(prevSq)][prevSq] = move;
+        thisThread->histories->counterMoves[pos.piece_on(prevSq)][prevSq] = move;
     }
   }
 
   // When playing with strength handicap, choose best move among a set of RootMoves
   // using a statistical rule dependent on 'level'. Idea by Heinz van Saanen.
 
-  Move Skill::pick_best(size_t multiPV) {
-
-    const RootMoves& rootMoves = Threads.main()->rootMoves;
-    static PRNG rng(now()); // PRNG sequence should be non-deterministic
+  Move Skill::pick_best(PRNG& rng, const RootMoves& rootMoves, size_t multiPV) {
 
     // RootMoves are already sorted by score in descending order
     Value topScore = rootMoves[0].score;
@@ -1832,12 +2055,14 @@ void MainThread::check_time() {
       return;
 
   // When using nodes, ensure checking rate is not lower than 0.1% of nodes
-  callsCnt = Limits.nodes ? std::min(1024, int(Limits.nodes / 1024)) : 1024;
+  callsCnt = engine.limits.nodes ? std::min(1024, int(engine.limits.nodes / 1024)) : 1024;
 
-  static TimePoint lastInfoTime = now();
+  // Publish our own counts first, so that "go nodes" with a single thread
+  // stops at the same node as with exact counters.
+  publish_counters();
 
-  TimePoint elapsed = Time.elapsed();
-  TimePoint tick = Limits.startTime + elapsed;
+  TimePoint elapsed = engine.time.elapsed();
+  TimePoint tick = engine.limits.startTime + elapsed;
 
   if (tick - lastInfoTime >= 1000)
   {
@@ -1849,10 +2074,10 @@ void MainThread::check_time() {
   if (ponder)
       return;
 
-  if (   (Limits.use_time_management() && (elapsed > Time.maximum() - 10 || stopOnPonderhit))
-      || (Limits.movetime && elapsed >= Limits.movetime)
-      || (Limits.nodes && Threads.nodes_searched() >= (uint64_t)Limits.nodes))
-      Threads.stop = true;
+  if (   (engine.limits.use_time_management() && (elapsed > engine.time.maximum() - 10 || stopOnPonderhit))
+      || (engine.limits.movetime && elapsed >= engine.limits.movetime)
+      || (engine.limits.nodes && engine.threads.nodes_searched() >= (uint64_t)engine.limits.nodes))
+      engine.threads.stop = true;
 }
 
 
@@ -1862,11 +2087,15 @@ void MainThread::check_time() {
 string UCI::pv(const Position& pos, Depth depth) {
 
   std::stringstream ss;
-  TimePoint elapsed = Time.elapsed() + 1;
+  Engine& engine = pos.this_thread()->engine;
+  pos.this_thread()->publish_counters(); // Our own counts are then exact
+  TimePoint elapsed = engine.time.elapsed() + 1;
   const RootMoves& rootMoves = pos.this_thread()->rootMoves;
   size_t pvIdx = pos.this_thread()->pvIdx;
-  size_t multiPV = std::min((size_t)Options["MultiPV"], rootMoves.size());
-  uint64_t nodesSearched = Threads.nodes_searched();
+  size_t multiPV = std::min((size_t)engine.options["MultiPV"], rootMoves.size());
+  uint64_t nodesSearched = engine.threads.nodes_searched();
+  uint64_t tbHits = engine.threads.tb_hits();
+  int hashfull = engine.tt.hashfull();
 
   for (size_t i = 0; i < multiPV; ++i)
   {
@@ -1895,8 +2124,8 @@ string UCI::pv(const Position& pos, Depth depth) {
 
       ss << " nodes "    << nodesSearched
          << " nps "      << nodesSearched * 1000 / elapsed
-         << " hashfull " << TT.hashfull()
-         << " tbhits "   << 0
+         << " hashfull " << hashfull
+         << " tbhits "   << tbHits
          << " time "     << elapsed
          << " pv";
 
@@ -1925,7 +2154,7 @@ bool RootMove::extract_ponder_from_tt(Position& pos) {
         return false;
 
     pos.do_move(pv[0], st);
-    TTEntry* tte = TT.probe(pos.key(), ttHit);
+    TTEntry* tte = pos.this_thread()->engine.tt.probe(pos.key(), ttHit);
 
     if (ttHit)
     {
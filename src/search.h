@@ -28,6 +28,7 @@
 namespace Stockfish {
 
 class Position;
+struct ThreadPool;
 
 namespace Search {
 
@@ -87,7 +88,7 @@ typedef std::vector<RootMove> RootMoves;
 struct LimitsType {
 
   LimitsType() { // Init explicitly due to broken value-initialization of non POD in MSVC
-    time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = TimePoint(0);
+    time[WHITE] = time[BLACK] = inc[WHITE] = inc[BLACK] = npmsec = movetime = startTime = TimePoint(0);
     movestogo = depth = mate = perft = infinite = 0;
     nodes = 0;
   }
@@ -102,10 +103,7 @@ struct LimitsType {
   int64_t nodes;
 };
 
-extern LimitsType Limits;
-
-void init();
-void clear();
+void init(ThreadPool& threads);
 
 } // namespace Search
 
@@ -0,0 +1,323 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "engine.h"
+#include "misc.h"
+#include "movegen.h"
+#include "selfplay.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace Stockfish {
+
+using SelfPlay::Game;
+
+namespace {
+
+  // iccs() converts a move to the ICCS notation used by xiangqi PGN files (H2-E2)
+
+  string iccs(Move m) {
+
+    string s = UCI::move(m);
+    return string{ char(toupper(s[0])), s[1], '-', char(toupper(s[2])), s[3] };
+  }
+
+  // adjudicate() tells whether the game is over in the current position, and
+  // if so sets its result and termination. The repetition rules, perpetual
+  // check and chase, and rule 60 are judged by Position::rule_judge().
+
+  bool adjudicate(const Position& pos, int maxPlies, Game& game) {
+
+    Value v;
+    Color us = pos.side_to_move();
+
+    if (!MoveList<LEGAL>(pos).size())
+    {
+        // In xiangqi a player without legal moves loses, even when not in check
+        v = -VALUE_MATE;
+        game.termination = pos.checkers() ? "checkmate" : "stalemate";
+    }
+    else if (pos.rule_judge(v))
+        game.termination =  v != VALUE_DRAW         ? "perpetual check or chase"
+                          : pos.rule60_count() >= 120 ? "60 move rule" : "repetition";
+    else if (int(game.moves.size()) >= maxPlies)
+    {
+        v = VALUE_DRAW;
+        game.termination = "adjudication, max plies";
+    }
+    else
+        return false;
+
+    game.result =  v == VALUE_DRAW        ? "1/2-1/2"
+                 : (v > 0) == (us == WHITE) ? "1-0" : "0-1";
+    return true;
+  }
+
+
+  // pgn() formats a finished game in PGN, with the moves in ICCS notation
+
+  string pgn(const Game& game, size_t round) {
+
+    stringstream ss;
+    string name = engine_info(true).substr(0, engine_info(true).find('\n'));
+    bool blackFirst = game.fen.find(" b ") != string::npos;
+
+    ss << "[Event \"Pikafish selfplay\"]\n"
+       << "[Site \"?\"]\n"
+       << "[Round \"" << round << "\"]\n"
+       << "[Red \"" << name << "\"]\n"
+       << "[Black \"" << name << "\"]\n"
+       << "[Result \"" << game.result << "\"]\n"
+       << "[FEN \"" << game.fen << "\"]\n"
+       << "[Format \"ICCS\"]\n"
+       << "[PlyCount \"" << game.moves.size() << "\"]\n"
+       << "[Termination \"" << game.termination << "\"]\n\n";
+
+    for (size_t i = 0; i < game.moves.size(); ++i)
+    {
+        if (i == 0 && blackFirst)
+            ss << "1... ";
+        else if ((i + blackFirst) % 2 == 0)
+            ss << (i + blackFirst) / 2 + 1 << ". ";
+
+        ss << iccs(game.moves[i]) << ((i + 1) % 12 ? " " : "\n");
+    }
+
+    ss << game.result << "\n\n";
+    return ss.str();
+  }
+
+} // namespace
+
+
+/// SelfPlay::play() plays a game between two engines, red first, from the
+/// given opening. After the opening, randomPlies random moves may be played
+/// to diversify the games, they are part of the opening in the result.
+
+Game SelfPlay::play(Engine* engines[], const string& opening, const Search::LimitsType& limits,
+                    int maxPlies, int randomPlies, uint64_t seed) {
+
+  Game game;
+  string fen, token;
+  vector<string> moves;
+  istringstream is(opening);
+
+  while (is >> token && token != "moves")
+      fen += token + " ";
+
+  while (is >> token)
+      moves.push_back(token);
+
+  for (int i = 0; i < 2; ++i)
+      engines[i]->clear();
+
+  if (!engines[0]->set_position(fen, moves))
+  {
+      game.termination = "illegal opening";
+      return game;
+  }
+
+  PRNG rng(seed);
+
+  for (int i = 0; i < randomPlies; ++i)
+  {
+      MoveList<LEGAL> legal(engines[0]->position());
+      if (!legal.size())
+          break;
+
+      moves.push_back(UCI::move(*(legal.begin() + rng.rand<uint64_t>() % legal.size())));
+      engines[0]->set_position(fen, moves);
+  }
+
+  // Like in a match the game starts after the opening, so that the engines
+  // do not see its moves. The position is kept here to judge the game.
+  game.fen = engines[0]->position().fen();
+  moves.clear();
+
+  StateListPtr states(new std::deque<StateInfo>(1));
+  Position pos;
+  pos.set(game.fen, &states->back(), engines[0]->threads.main());
+
+  while (!adjudicate(pos, maxPlies, game))
+  {
+      Engine& e = *engines[pos.side_to_move() == WHITE ? 0 : 1];
+
+      e.set_position(game.fen, moves);
+      Engine::Result r = e.search(limits);
+      game.nodes += r.nodes;
+
+      game.moves.push_back(r.bestMove);
+      game.scores.push_back(r.score);
+      moves.push_back(UCI::move(r.bestMove));
+      states->emplace_back();
+      pos.do_move(r.bestMove, states->back());
+  }
+
+  return game;
+}
+
+
+/// selfplay() is called when the engine receives the "selfplay" command:
+///
+/// selfplay <file>|startpos depth|nodes|movetime <n> [games <g>] [jobs <j>]
+///          [pgn <file>] [maxplies <m>]
+///
+/// It plays g games, j at a time, each between two engines of one thread that
+/// are cleared before every game. The openings, one per line of the file in
+/// the format of the "analyse" command, are used in turn. The games are judged
+/// with the xiangqi rules of the current options and adjudicated as drawn after
+/// m plies (default 400). A line is printed for every finished game, then a
+/// summary with the aggregate speed. The games are also written to a PGN file
+/// if one is given.
+
+void selfplay(Engine& engine, istream& args) {
+
+  string token, openingFile, limitType, pgnFile;
+  int64_t limit = 0;
+  size_t games = 1, jobs = 1;
+  int maxPlies = 400;
+
+  args >> openingFile >> limitType >> limit;
+
+  while (args >> token)
+      if (token == "games")
+          args >> games;
+      else if (token == "jobs")
+          args >> jobs;
+      else if (token == "pgn")
+          args >> pgnFile;
+      else if (token == "maxplies")
+          args >> maxPlies;
+
+  if (   limit <= 0
+      || (limitType != "depth" && limitType != "nodes" && limitType != "movetime"))
+  {
+      sync_cout << "Usage: selfplay <file>|startpos depth|nodes|movetime <n> [games <g>] [jobs <j>]"
+                   " [pgn <file>] [maxplies <m>]" << sync_endl;
+      return;
+  }
+
+  vector<string> openings;
+
+  if (openingFile == "startpos")
+      openings.push_back(StartFEN);
+  else
+  {
+      ifstream file(openingFile);
+      if (!file.is_open())
+      {
+          sync_cout << "Unable to open file " << openingFile << sync_endl;
+          return;
+      }
+
+      string line;
+      while (getline(file, line))
+          if (line.find_first_not_of(" \t\r") != string::npos)
+              openings.push_back(line);
+
+      if (openings.empty())
+          return;
+  }
+
+  ofstream pgnOut;
+  if (!pgnFile.empty())
+  {
+      pgnOut.open(pgnFile, ios::app);
+      if (!pgnOut.is_open())
+      {
+          sync_cout << "Unable to open file " << pgnFile << sync_endl;
+          return;
+      }
+  }
+
+  Search::LimitsType limits;
+  if (limitType == "depth")
+      limits.depth = int(limit);
+  else if (limitType == "nodes")
+      limits.nodes = limit;
+  else
+      limits.movetime = limit;
+
+  jobs = std::clamp(jobs, size_t(1), std::max(games, size_t(1)));
+  size_t hashMB = std::max(size_t(engine.options["Hash"]) / (2 * jobs), size_t(1));
+  atomic<size_t> next(0);
+  atomic<uint64_t> totalNodes(0);
+  size_t wins[COLOR_NB] = {}, draws = 0, plies = 0;
+  mutex resultMutex;
+  vector<thread> workers;
+
+  engine.wait_for_search_finished();
+  TimePoint elapsed = now();
+
+  for (size_t j = 0; j < jobs; ++j)
+      workers.emplace_back([&] {
+
+          Engine red, black;
+          Engine* engines[] = { &red, &black };
+
+          for (Engine* e : engines)
+          {
+              e->onOutput = nullptr;
+              e->set_option("Hash", std::to_string(hashMB));
+          }
+
+          for (size_t idx = next++; idx < games; idx = next++)
+          {
+              Game game = SelfPlay::play(engines, openings[idx % openings.size()], limits, maxPlies);
+              totalNodes += game.nodes;
+
+              std::lock_guard<mutex> lk(resultMutex);
+
+              wins[WHITE] += game.result == "1-0";
+              wins[BLACK] += game.result == "0-1";
+              draws       += game.result == "1/2-1/2";
+              plies       += game.moves.size();
+
+              if (pgnOut.is_open() && !game.fen.empty())
+                  pgnOut << pgn(game, idx + 1) << flush;
+
+              sync_cout << "Finished game " << idx + 1 << ": " << game.result
+                        << " {" << game.termination << "}" << sync_endl;
+          }
+      });
+
+  for (thread& th : workers)
+      th.join();
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  sync_cout << "\n==========================="
+            << "\nGames           : " << games
+            << "\nRed/Black/Draw  : " << wins[WHITE] << "/" << wins[BLACK] << "/" << draws
+            << "\nPlies           : " << plies
+            << "\nTotal time (ms) : " << elapsed
+            << "\nNodes searched  : " << totalNodes
+            << "\nNodes/second    : " << 1000 * totalNodes / elapsed << sync_endl;
+}
+
+} // namespace Stockfish
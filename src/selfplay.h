@@ -0,0 +1,52 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SELFPLAY_H_INCLUDED
+#define SELFPLAY_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include "search.h"
+#include "types.h"
+
+namespace Stockfish {
+
+class Engine;
+
+namespace SelfPlay {
+
+/// Game stores a game played by the engines, used by "selfplay" and "datagen"
+
+struct Game {
+  std::string fen;           // Of the starting position, after the opening
+  std::vector<Move> moves;   // Played by the engines
+  std::vector<Value> scores; // Of the searches, for the side that moved
+  std::string result = "*";  // "1-0", "0-1", "1/2-1/2", "*" if not played
+  std::string termination;
+  uint64_t nodes = 0;
+};
+
+Game play(Engine* engines[], const std::string& opening, const Search::LimitsType& limits,
+          int maxPlies, int randomPlies = 0, uint64_t seed = 1);
+
+} // namespace SelfPlay
+
+} // namespace Stockfish
+
+#endif // #ifndef SELFPLAY_H_INCLUDED
@@ -0,0 +1,625 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "datagen.h"
+#include "engine.h"
+#include "evaluate.h"
+#include "material.h"
+#include "misc.h"
+#include "position.h"
+#include "texel.h"
+#include "uci.h"
+
+using namespace std;
+
+namespace Stockfish {
+
+using namespace Texel;
+
+namespace {
+
+  const char* PieceTypeNames[] = { "", "ROOK", "ADVISOR", "CANNON", "PAWN", "KNIGHT", "BISHOP", "KING" };
+  const char* ImbalanceNames[] = { "ROOK", "ADVISOR", "CANNON", "PAWN", "KNIGHT", "BISHOP" };
+
+  // Table describes a table of evalparams.h: how it is declared and commented
+  // there, where it is in the coefficient vector, and the divisor applied to
+  // it by the evaluation. The tables are listed in the order of the file.
+
+  struct Table {
+    const char* name;
+    const char* declaration;  // Array dimensions as declared
+    vector<int> shape;
+    Param offset;
+    int divisor;
+    const char** labels;      // Comments of the rows, if any
+    const char* comment;
+  };
+
+  const Table Tables[] = {
+    { "HollowCannon", "", {}, HOLLOW_CANNON, 1, nullptr,
+      "Cannon on the central file facing the king, with its advisors home and no\n"
+      "piece in between" },
+    { "CentralKnight", "", {}, CENTRAL_KNIGHT, 1, nullptr,
+      "Cannon on the central file pinning a knight in the center of the palace" },
+    { "BottomCannon", "", {}, BOTTOM_CANNON, 1, nullptr,
+      "Cannon on the enemy back rank facing the king" },
+    { "AdvisorBishopPair", "", {}, ADVISOR_BISHOP_PAIR, 1, nullptr,
+      "Both advisors and both bishops" },
+    { "ConnectedPawn", "", {}, CONNECTED_PAWN, 1, nullptr,
+      "Pawns side by side" },
+    { "TrappedKnight", "", {}, TRAPPED_KNIGHT, 1, nullptr,
+      "Knight on the edge of the board between a rook of each side" },
+    { "CrossedPawn", "[3][6]", { 3, 6 }, CROSSED_PAWN, 1, nullptr,
+      "Pawns across the river, not on the last rank, by number of enemy advisors\n"
+      "and number of such pawns" },
+    { "RookOnOpenFile", "[2]", { 2 }, ROOK_ON_OPEN_FILE, 1, nullptr,
+      "Rook on a semi-open file, by whether the file is open" },
+    { "PiecesOnOneSide", "[5]", { 5 }, PIECES_ON_ONE_SIDE, 1, nullptr,
+      "Rooks, knights and cannons across the river on one wing of the board and\n"
+      "not attacked, by their number" },
+    { "MobilityBonus", "[PIECE_TYPE_NB][18]", { PIECE_TYPE_NB, 18 },
+      MOBILITY_BONUS, 100, PieceTypeNames,
+      "Mobility by piece type and number of squares attacked that are not attacked\n"
+      "by enemy pawns, in hundredths" },
+    { "QuadraticOurs", "[6][6]", { 6, 6 }, QUADRATIC_OURS, 16, ImbalanceNames,
+      "Material imbalance, one parameter for each pair (our piece, another of our\n"
+      "pieces), in sixteenths" },
+    { "QuadraticTheirs", "[6][6]", { 6, 6 }, QUADRATIC_THEIRS, 16, ImbalanceNames,
+      "Material imbalance, one parameter for each pair (our piece, their piece),\n"
+      "in sixteenths" },
+    { "Bonus", "[PIECE_TYPE_NB][RANK_NB][int(FILE_NB) / 2 + 1]", { PIECE_TYPE_NB, RANK_NB, FILE_NB / 2 + 1 },
+      PSQ_BONUS, 1, PieceTypeNames,
+      "Piece-square bonus, added to the piece values. Scores are explicit for files\n"
+      "A to E, implicitly mirrored for E to I." }
+  };
+
+  int size_of(const Table& t) {
+
+    int size = 1;
+    for (int d : t.shape)
+        size *= d;
+    return size;
+  }
+
+
+  // Weights are the parameters being tuned, as real numbers
+  struct Weight { double mg, eg; };
+
+
+  // Entry is a non-zero coefficient of a traced position
+  struct Entry {
+    uint16_t param;
+    int16_t coefficient;
+  };
+
+  // Sample is a traced position. Its evaluation, linear in the weights, is
+  //
+  //   damping * (offset + sum of coefficient * weight / divisor)
+  //
+  // where the sum is over the entries, and the weights are the interpolation
+  // of their mg and eg parts by the game phase. The offset holds what is not
+  // tuned, like the piece values, and the rounding errors of the evaluation.
+
+  struct Sample {
+    uint64_t begin;       // Of its entries
+    uint32_t count;
+    float phase;          // Weight of the mg part, in [0, 1]
+    float damping;        // Rule 60 damping
+    float offset;
+    float result;         // Result of the game for white, in [0, 1]
+    float score;          // Score of the search for white
+    float target;         // Result until Tuner::set_targets()
+  };
+
+
+  string format(Weight w) {
+
+    stringstream ss;
+    ss << "S(" << setw(4) << lround(w.mg) << "," << setw(4) << lround(w.eg) << ")";
+    return ss.str();
+  }
+
+  string format_row(const Weight* w, int n) {
+
+    string s = "{ ";
+    for (int i = 0; i < n; ++i)
+        s += (i ? ", " : "") + format(w[i]);
+    return s + " }";
+  }
+
+
+  // write_header() writes the weights as a new evalparams.h
+
+  bool write_header(const string& fname, const vector<Weight>& weights) {
+
+    ofstream out(fname);
+    if (!out.is_open())
+        return false;
+
+    out << "/*\n"
+           "  Stockfish, a UCI chess playing engine derived from Glaurung 2.1\n"
+           "  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)\n"
+           "\n"
+           "  Stockfish is free software: you can redistribute it and/or modify\n"
+           "  it under the terms of the GNU General Public License as published by\n"
+           "  the Free Software Foundation, either version 3 of the License, or\n"
+           "  (at your option) any later version.\n"
+           "\n"
+           "  Stockfish is distributed in the hope that it will be useful,\n"
+           "  but WITHOUT ANY WARRANTY; without even the implied warranty of\n"
+           "  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the\n"
+           "  GNU General Public License for more details.\n"
+           "\n"
+           "  You should have received a copy of the GNU General Public License\n"
+           "  along with this program.  If not, see <http://www.gnu.org/licenses/>.\n"
+           "*/\n"
+           "\n"
+           "#ifndef EVALPARAMS_H_INCLUDED\n"
+           "#define EVALPARAMS_H_INCLUDED\n"
+           "\n"
+           "#include \"types.h\"\n"
+           "\n"
+           "// The parameters of the classical evaluation. This file is written by the\n"
+           "// \"texel\" command, which tunes them on a set of positions.\n"
+           "\n"
+           "namespace Stockfish::Eval {\n"
+           "\n"
+           "#define S(mg, eg) make_score(mg, eg)\n";
+
+    for (const Table& t : Tables)
+    {
+        const Weight* w = &weights[t.offset];
+        string comment = t.comment, line;
+        istringstream is(comment);
+
+        out << "\n";
+        while (getline(is, line))
+            out << "// " << line << "\n";
+
+        out << "constexpr Score " << t.name << t.declaration << " = ";
+
+        if (t.shape.empty())
+        {
+            out << format(w[0]) << ";\n";
+            continue;
+        }
+
+        if (t.shape.size() == 1)
+        {
+            out << format_row(w, t.shape[0]) << ";\n";
+            continue;
+        }
+
+        out << "{\n";
+
+        int rowSize = size_of(t) / t.shape[0];
+        for (int i = 0; i < t.shape[0]; ++i, w += rowSize)
+        {
+            string label = t.labels && *t.labels[i] ? string(" // ") + t.labels[i] : "";
+
+            if (std::all_of(w, w + rowSize, [](Weight x) { return !lround(x.mg) && !lround(x.eg); }))
+                out << "  { }," << label << "\n";
+
+            else if (t.shape.size() == 2)
+                out << "  " << format_row(w, rowSize) << "," << label << "\n";
+
+            else
+            {
+                out << "  {" << label << "\n";
+                for (int j = 0; j < t.shape[1]; ++j)
+                    out << "    " << format_row(w + j * t.shape[2], t.shape[2]) << ",\n";
+                out << "  },\n";
+            }
+        }
+
+        out << "};\n";
+    }
+
+    out << "\n"
+           "#undef S\n"
+           "\n"
+           "} // namespace Stockfish::Eval\n"
+           "\n"
+           "#endif // #ifndef EVALPARAMS_H_INCLUDED\n";
+
+    return bool(out);
+  }
+
+
+  // write() writes the weights as a parameter file for the EvalFile option if
+  // the file name ends with ".bin", else as a new evalparams.h.
+
+  bool write(const string& fname, const vector<Weight>& weights) {
+
+    if (fname.size() < 4 || fname.compare(fname.size() - 4, 4, ".bin"))
+        return write_header(fname, weights);
+
+    Eval::Params p;
+    for (int i = 0; i < PARAM_NB; ++i)
+        p.data()[i] = make_score(int(lround(weights[i].mg)), int(lround(weights[i].eg)));
+
+    return Eval::save_params(fname, p);
+  }
+
+
+  // parallel() calls f(begin, end, job) on j slices of [0, n) in j threads
+  // and waits for them.
+
+  template<typename F>
+  void parallel(size_t n, size_t jobs, F f) {
+
+    vector<thread> workers;
+
+    for (size_t j = 0; j < jobs; ++j)
+        workers.emplace_back(f, n * j / jobs, n * (j + 1) / jobs, j);
+
+    for (thread& th : workers)
+        th.join();
+  }
+
+  double sigmoid(double k, double v) { return 1 / (1 + std::exp(-k * v)); }
+
+
+  // Tuner holds the traced positions and computes the mean squared error of
+  // their evaluations, and its gradient, across all the jobs.
+
+  class Tuner {
+
+  public:
+    Tuner(size_t j) : jobs(j) {
+
+      const Score* values = Eval::params.data();
+      weights.resize(PARAM_NB);
+      scale.resize(PARAM_NB);
+
+      for (const Table& t : Tables)
+          for (int i = 0; i < size_of(t); ++i)
+          {
+              weights[t.offset + i] = { double(mg_value(values[t.offset + i])), double(eg_value(values[t.offset + i])) };
+              scale[t.offset + i] = 1.0 / t.divisor;
+          }
+    }
+
+    void trace(const PackedPosition* records, size_t n);
+    double error(double k, vector<Weight>* gradient = nullptr) const;
+    double fit_k() const;
+    void set_targets(double k, double lambda);
+
+    size_t jobs;
+    vector<Weight> weights;
+    vector<double> scale;    // Inverse of the divisors
+    vector<Sample> samples;
+    vector<Entry> entries;
+  };
+
+
+  // Tuner::trace() traces the records in parallel, skipping the positions that
+  // do not have a linear evaluation: in check or with a specialized one.
+
+  void Tuner::trace(const PackedPosition* records, size_t n) {
+
+    vector<vector<Sample>> jobSamples(jobs);
+    vector<vector<Entry>> jobEntries(jobs);
+
+    parallel(n, jobs, [&](size_t begin, size_t end, size_t job) {
+
+        // An engine gives the thread and its material table to the positions
+        Engine engine;
+        engine.set_option("Hash", "1");
+
+        vector<Sample>& smp = jobSamples[job];
+        vector<Entry>& ent = jobEntries[job];
+        int coefficients[PARAM_NB];
+        StateInfo st;
+        Position pos;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const PackedPosition& pp = records[i];
+            pos.set(pp.fen(), &st, engine.threads.main());
+
+            if (pos.checkers())
+                continue;
+
+            // The linear model does not hold for the endgame functions
+            const Material::Entry* me = Material::probe(pos);
+            if (me->specialized_eval_exists() || me->specialized_scale_exists())
+                continue;
+
+            Value v = Eval::trace(pos, coefficients);
+            Sample s = {};
+            double linear = 0, phase = Material::probe(pos)->game_phase() / double(PHASE_MIDGAME);
+
+            s.begin = ent.size();
+
+            for (int p = 0; p < PARAM_NB; ++p)
+                if (coefficients[p])
+                {
+                    ent.push_back({ uint16_t(p), int16_t(coefficients[p]) });
+                    linear += coefficients[p] * scale[p] * (weights[p].mg * phase + weights[p].eg * (1 - phase));
+                }
+
+            Color us = pp.side_to_move();
+            s.count   = uint32_t(ent.size() - s.begin);
+            s.phase   = float(phase);
+            s.damping = float(Eval::Rule60A - pos.rule60_count()) / Eval::Rule60B;
+            s.offset  = float(int(v) - linear);
+            s.result  = ((us == WHITE ? pp.result : -pp.result) + 1) / 2.0f;
+            s.score   = float(us == WHITE ? pp.score : -pp.score);
+            s.target  = s.result;
+            smp.push_back(s);
+        }
+    });
+
+    // Concatenate the results of the jobs, in the order of the records
+    for (size_t j = 0; j < jobs; ++j)
+    {
+        for (Sample& s : jobSamples[j])
+            s.begin += entries.size();
+
+        samples.insert(samples.end(), jobSamples[j].begin(), jobSamples[j].end());
+        entries.insert(entries.end(), jobEntries[j].begin(), jobEntries[j].end());
+    }
+  }
+
+
+  // Tuner::error() returns the mean squared error of the evaluations of the
+  // samples mapped by a sigmoid of scale k against their targets. It also
+  // computes its gradient with respect to the weights if asked to.
+
+  double Tuner::error(double k, vector<Weight>* gradient) const {
+
+    vector<double> jobErrors(jobs);
+    vector<vector<Weight>> jobGradients(gradient ? jobs : 0, vector<Weight>(PARAM_NB));
+
+    parallel(samples.size(), jobs, [&](size_t begin, size_t end, size_t job) {
+
+        double sum = 0;
+
+        for (size_t i = begin; i < end; ++i)
+        {
+            const Sample& s = samples[i];
+            const Entry* e = &entries[s.begin];
+            double mg = 0, eg = 0;
+
+            for (uint32_t j = 0; j < s.count; ++j)
+            {
+                double c = e[j].coefficient * scale[e[j].param];
+                mg += c * weights[e[j].param].mg;
+                eg += c * weights[e[j].param].eg;
+            }
+
+            double v = s.damping * (s.offset + mg * s.phase + eg * (1 - s.phase));
+            double p = sigmoid(k, v);
+            double err = p - s.target;
+            sum += err * err;
+
+            if (gradient)
+            {
+                double g = 2 * err * p * (1 - p) * k * s.damping;
+                Weight* grad = jobGradients[job].data();
+
+                for (uint32_t j = 0; j < s.count; ++j)
+                {
+                    double c = g * e[j].coefficient * scale[e[j].param];
+                    grad[e[j].param].mg += c * s.phase;
+                    grad[e[j].param].eg += c * (1 - s.phase);
+                }
+            }
+        }
+
+        jobErrors[job] = sum;
+    });
+
+    double n = double(std::max(samples.size(), size_t(1)));
+
+    if (gradient)
+    {
+        gradient->assign(PARAM_NB, { 0, 0 });
+
+        for (const vector<Weight>& g : jobGradients)
+            for (int p = 0; p < PARAM_NB; ++p)
+            {
+                (*gradient)[p].mg += g[p].mg / n;
+                (*gradient)[p].eg += g[p].eg / n;
+            }
+    }
+
+    double sum = 0;
+    for (double e : jobErrors)
+        sum += e;
+
+    return sum / n;
+  }
+
+
+  // Tuner::fit_k() finds the scale of the sigmoid that best maps the current
+  // evaluations to the results, by a golden section search on its logarithm.
+
+  double Tuner::fit_k() const {
+
+    const double phi = (std::sqrt(5.0) - 1) / 2;
+    double lo = std::log(1e-4), hi = std::log(1e-1);
+
+    for (int i = 0; i < 40; ++i)
+    {
+        double a = hi - phi * (hi - lo), b = lo + phi * (hi - lo);
+
+        if (error(std::exp(a)) < error(std::exp(b)))
+            hi = b;
+        else
+            lo = a;
+    }
+
+    return std::exp((lo + hi) / 2);
+  }
+
+
+  // Tuner::set_targets() blends the results with the scores of the searches
+
+  void Tuner::set_targets(double k, double lambda) {
+
+    for (Sample& s : samples)
+        s.target = float(lambda * s.result + (1 - lambda) * sigmoid(k, s.score));
+  }
+
+} // namespace
+
+
+/// texel() is called when the engine receives the "texel" command:
+///
+/// texel <file> [epochs <n>] [lr <x>] [lambda <x>] [k <x>] [jobs <j>] [out <file>]
+///
+/// It tunes the evaluation parameters in use, those of evalparams.h unless an
+/// EvalFile is loaded, on a file of PackedPosition records written by "datagen",
+/// which is memory mapped. The classical evaluation is linear in the parameters,
+/// except for rounding, so every position is traced once (see Eval::trace()),
+/// then the mean squared error between the evaluations mapped to [0, 1] by a
+/// sigmoid of scale k and the targets is minimized with Adam, each epoch
+/// computing the full gradient in j threads (by default one per thread of the
+/// "Threads" option). The target of a position is the game result, blended with
+/// the score of the search unless lambda is 1 (default 0.5). If k is not given,
+/// it is fitted first to the current parameters. The learning rate (default 1)
+/// is about the step of a parameter in an epoch, in evaluation units. The tuned
+/// parameters are written every 100 epochs and at the end to a new parameter
+/// header (default "evalparams_tuned.h"), to replace evalparams.h, or to a
+/// parameter file for the EvalFile option if its name ends with ".bin".
+
+void texel(Engine& engine, istream& args) {
+
+  string token, dataFile, outFile = "evalparams_tuned.h";
+  int epochs = 300;
+  double lr = 1, lambda = 0.5, k = 0;
+  size_t jobs = size_t(engine.options["Threads"]);
+
+  args >> dataFile;
+
+  while (args >> token)
+      if (token == "epochs")
+          args >> epochs;
+      else if (token == "lr")
+          args >> lr;
+      else if (token == "lambda")
+          args >> lambda;
+      else if (token == "k")
+          args >> k;
+      else if (token == "jobs")
+          args >> jobs;
+      else if (token == "out")
+          args >> outFile;
+
+  if (dataFile.empty() || epochs < 0 || lr <= 0 || lambda < 0 || lambda > 1)
+  {
+      sync_cout << "Usage: texel <file> [epochs <n>] [lr <x>] [lambda <x>] [k <x>] [jobs <j>] [out <file>]" << sync_endl;
+      return;
+  }
+
+  if (!FullEvaluation)
+  {
+      sync_cout << "The tuner needs the FullEvaluation option" << sync_endl;
+      return;
+  }
+
+  MappedFile data;
+  if (!data.open(dataFile) || data.size() % sizeof(PackedPosition))
+  {
+      sync_cout << "Unable to open file " << dataFile << sync_endl;
+      return;
+  }
+
+  engine.wait_for_search_finished();
+  TimePoint elapsed = now();
+
+  size_t records = data.size() / sizeof(PackedPosition);
+  Tuner tuner(std::clamp(jobs, size_t(1), std::max(records, size_t(1))));
+
+  tuner.trace(static_cast<const PackedPosition*>(data.data()), records);
+  data.close();
+
+  sync_cout << "Traced " << tuner.samples.size() << " positions of " << records
+            << " in " << now() - elapsed << " ms" << sync_endl;
+
+  if (tuner.samples.empty())
+      return;
+
+  if (k <= 0)
+      k = tuner.fit_k();
+
+  tuner.set_targets(k, lambda);
+
+  double initialError = tuner.error(k), err = initialError;
+  sync_cout << "K " << k << ", error " << initialError << sync_endl;
+
+  // Adam, with the steps of each parameter scaled by its divisor so that
+  // they are the same in evaluation units.
+  const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+  vector<Weight> gradient, m(PARAM_NB), v(PARAM_NB);
+
+  for (int epoch = 1; epoch <= epochs; ++epoch)
+  {
+      err = tuner.error(k, &gradient);
+
+      double c1 = 1 - std::pow(beta1, epoch), c2 = 1 - std::pow(beta2, epoch);
+
+      for (int p = 0; p < PARAM_NB; ++p)
+      {
+          double step = lr / tuner.scale[p];
+
+          m[p].mg = beta1 * m[p].mg + (1 - beta1) * gradient[p].mg;
+          m[p].eg = beta1 * m[p].eg + (1 - beta1) * gradient[p].eg;
+          v[p].mg = beta2 * v[p].mg + (1 - beta2) * gradient[p].mg * gradient[p].mg;
+          v[p].eg = beta2 * v[p].eg + (1 - beta2) * gradient[p].eg * gradient[p].eg;
+
+          tuner.weights[p].mg -= step * (m[p].mg / c1) / (std::sqrt(v[p].mg / c2) + epsilon);
+          tuner.weights[p].eg -= step * (m[p].eg / c1) / (std::sqrt(v[p].eg / c2) + epsilon);
+
+          // Both halves of a Score are 16 bit
+          tuner.weights[p].mg = std::clamp(tuner.weights[p].mg, -32767.0, 32767.0);
+          tuner.weights[p].eg = std::clamp(tuner.weights[p].eg, -32767.0, 32767.0);
+      }
+
+      if (epoch % 10 == 0)
+          sync_cout << "Epoch " << epoch << ", error " << err << sync_endl;
+
+      if (epoch % 100 == 0)
+          write(outFile, tuner.weights);
+  }
+
+  if (!write(outFile, tuner.weights))
+      sync_cout << "Unable to write file " << outFile << sync_endl;
+
+  elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
+
+  sync_cout << "\n==========================="
+            << "\nPositions       : " << tuner.samples.size()
+            << "\nK               : " << k
+            << "\nInitial error   : " << initialError
+            << "\nFinal error     : " << tuner.error(k)
+            << "\nTotal time (ms) : " << elapsed << sync_endl;
+}
+
+} // namespace Stockfish
@@ -0,0 +1,80 @@
+/*
+  Stockfish, a UCI chess playing engine derived from Glaurung 2.1
+  Copyright (C) 2004-2022 The Stockfish developers (see AUTHORS file)
+
+  Stockfish is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Stockfish is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TEXEL_H_INCLUDED
+#define TEXEL_H_INCLUDED
+
+#include <cstddef>
+#include <type_traits>
+
+#include "evaluate.h"
+#include "types.h"
+
+namespace Stockfish::Texel {
+
+/// Param gives the offsets of the tables of Eval::Params in its flat array of
+/// Score, which is also the coefficient vector of a traced evaluation (see
+/// Eval::trace()). The tables are flattened in row-major order.
+
+#define PARAM_OFFSET(t) int(offsetof(Eval::Params, t) / sizeof(Score))
+
+enum Param : int {
+  HOLLOW_CANNON       = PARAM_OFFSET(HollowCannon),
+  CENTRAL_KNIGHT      = PARAM_OFFSET(CentralKnight),
+  BOTTOM_CANNON       = PARAM_OFFSET(BottomCannon),
+  ADVISOR_BISHOP_PAIR = PARAM_OFFSET(AdvisorBishopPair),
+  CONNECTED_PAWN      = PARAM_OFFSET(ConnectedPawn),
+  TRAPPED_KNIGHT      = PARAM_OFFSET(TrappedKnight),
+  CROSSED_PAWN        = PARAM_OFFSET(CrossedPawn),
+  ROOK_ON_OPEN_FILE   = PARAM_OFFSET(RookOnOpenFile),
+  PIECES_ON_ONE_SIDE  = PARAM_OFFSET(PiecesOnOneSide),
+  MOBILITY_BONUS      = PARAM_OFFSET(MobilityBonus),
+  QUADRATIC_OURS      = PARAM_OFFSET(QuadraticOurs),
+  QUADRATIC_THEIRS    = PARAM_OFFSET(QuadraticTheirs),
+  PSQ_BONUS           = PARAM_OFFSET(Bonus),
+  PARAM_NB            = PSQ_BONUS + int(sizeof(Eval::Params::Bonus) / sizeof(Score))
+};
+
+#undef PARAM_OFFSET
+
+// The tables are read as one array of PARAM_NB Score from Eval::Params::data(),
+// so the block must be made of tables of Score only, without any padding. A
+// member of another type, or a gap, makes the counts below differ.
+
+template<typename T>
+constexpr int score_count() {
+  static_assert(std::is_same_v<std::remove_all_extents_t<T>, Score>, "Eval::Params must hold only Score");
+  return int(sizeof(T) / sizeof(Score));
+}
+
+#define PARAM_COUNT(t) score_count<decltype(Eval::Params::t)>()
+
+static_assert(std::is_standard_layout_v<Eval::Params> && offsetof(Eval::Params, HollowCannon) == 0,
+              "Eval::Params must start with its first table");
+static_assert(  PARAM_COUNT(HollowCannon) + PARAM_COUNT(CentralKnight) + PARAM_COUNT(BottomCannon)
+              + PARAM_COUNT(AdvisorBishopPair) + PARAM_COUNT(ConnectedPawn) + PARAM_COUNT(TrappedKnight)
+              + PARAM_COUNT(CrossedPawn) + PARAM_COUNT(RookOnOpenFile) + PARAM_COUNT(PiecesOnOneSide)
+              + PARAM_COUNT(MobilityBonus) + PARAM_COUNT(QuadraticOurs) + PARAM_COUNT(QuadraticTheirs)
+              + PARAM_COUNT(Bonus) == PARAM_NB,
+              "Eval::Params must be a gap-free run of Score");
+
+#undef PARAM_COUNT
+
+} // namespace Stockfish::Texel
+
+#endif // #ifndef TEXEL_H_INCLUDED
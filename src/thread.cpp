@@ -19,6 +19,7 @@
 #include <cassert>
 
 #include <algorithm> // For std::count
+#include "engine.h"
 #include "movegen.h"
 #include "search.h"
 #include "thread.h"
@@ -27,16 +28,12 @@
 
 namespace Stockfish {
 
-ThreadPool Threads; // Global object
+/// Thread constructor launches the thread, which clears its tables and then
+/// goes to sleep in idle_loop(). The caller must wait for it with
+/// wait_for_search_finished(). Note that 'searching' and 'exit' should be
+/// already set.
 
-
-/// Thread constructor launches the thread and waits until it goes to sleep
-/// in idle_loop(). Note that 'searching' and 'exit' should be already set.
-
-Thread::Thread(size_t n) : idx(n), stdThread(&Thread::idle_loop, this) {
-
-  wait_for_search_finished();
-}
+Thread::Thread(Engine& e, size_t n) : engine(e), idx(n), stdThread(&Thread::idle_loop, this) {}
 
 
 /// Thread destructor wakes up the thread in idle_loop() and waits
@@ -46,8 +43,13 @@ Thread::~Thread() {
 
   assert(!searching);
 
-  exit = true;
-  start_searching();
+  // The helpers are told to exit by ThreadPool::set(), all at once
+  if (!idx)
+  {
+      exit = true;
+      start_searching();
+  }
+
   stdThread.join();
 }
 
@@ -56,16 +58,15 @@ Thread::~Thread() {
 
 void Thread::clear() {
 
-  counterMoves.fill(MOVE_NONE);
-  mainHistory.fill(0);
-  captureHistory.fill(0);
+  ownHistories.counterMoves.fill(MOVE_NONE);
+  ownHistories.mainHistory.fill(0);
+  ownHistories.captureHistory.fill(0);
   previousDepth = 0;
   
   for (bool inCheck : { false, true })
       for (StatsType c : { NoCaptures, Captures })
-          for (auto& to : continuationHistory[inCheck][c])
-              for (auto& h : to)
-                  h->fill(-71);
+          for (auto& h : ownHistories.continuationHistory[inCheck][c])
+              h->fill(-71);
 }
 
 
@@ -79,6 +80,22 @@ void Thread::start_searching() {
 }
 
 
+/// Thread::run_custom_job() runs a function on the thread instead of a search.
+/// Only the main thread uses it, the helpers run the jobs of the pool.
+
+void Thread::run_custom_job(std::function<void()> f) {
+
+  {
+      std::unique_lock<std::mutex> lk(mutex);
+      cv.wait(lk, [&]{ return !searching; });
+      jobFunc = std::move(f);
+      searching = true;
+  }
+
+  cv.notify_one();
+}
+
+
 /// Thread::wait_for_search_finished() blocks on the condition variable
 /// until the thread has finished searching.
 
@@ -90,7 +107,9 @@ void Thread::wait_for_search_finished() {
 
 
 /// Thread::idle_loop() is where the thread is parked, blocked on the
-/// condition variable, when it has no work to do.
+/// condition variable, when it has no work to do. The helpers wait on the
+/// one of the pool instead of their own once they are ready, see
+/// ThreadPool::start_searching().
 
 void Thread::idle_loop() {
 
@@ -99,9 +118,67 @@ void Thread::idle_loop() {
   // some Windows NUMA hardware, for instance in fishtest. To make it simple,
   // just check if running threads are below a threshold, in this case all this
   // NUMA machinery is not needed.
-  if (Options["Threads"] > 8)
+  if (engine.options["Threads"] > 8)
       WinProcGroup::bindThisThread(idx);
 
+#if defined(USE_NUMA)
+  // Bind to a node and switch to its replica of the lookup tables
+  if (engine.options["NUMA Replication"])
+      Numa::bind_this_thread(idx);
+#endif
+
+  // The tables are first written by the thread itself, once bound, so that
+  // their pages are allocated on its node under a first touch policy.
+  materialTable = Material::Table();
+  clear();
+
+  if (idx)
+  {
+      ThreadPool& pool = engine.threads;
+      uint64_t generation;
+
+      {
+          std::lock_guard<std::mutex> lk(pool.startMutex);
+          generation = pool.generation;
+      }
+
+      {
+          std::lock_guard<std::mutex> lk(mutex);
+          searching = false;
+          cv.notify_one(); // Wake up the constructor
+      }
+
+      while (true)
+      {
+          std::function<void(Thread&)> job;
+
+          {
+              std::unique_lock<std::mutex> lk(pool.startMutex);
+              pool.startCv.wait(lk, [&]{ return exit || pool.generation != generation; });
+
+              if (exit)
+                  return;
+
+              generation = pool.generation;
+              job = pool.helperJob;
+          }
+
+          if (job)
+              job(*this);
+          else
+          {
+              rootMoves = pool.setupRootMoves;
+              rootPos.set(*pool.setupPos, &rootState, this);
+
+              search();
+          }
+
+          std::lock_guard<std::mutex> lk(pool.startMutex);
+          if (--pool.helpersSearching == 0)
+              pool.doneCv.notify_all();
+      }
+  }
+
   while (true)
   {
       std::unique_lock<std::mutex> lk(mutex);
@@ -112,40 +189,63 @@ void Thread::idle_loop() {
       if (exit)
           return;
 
+      std::function<void()> job = std::move(jobFunc);
+      jobFunc = nullptr;
       lk.unlock();
 
-      search();
+      if (job)
+          job();
+      else
+          search();
   }
 }
 
 /// ThreadPool::set() creates/destroys threads to match the requested number.
 /// Created and launched threads will immediately go to sleep in idle_loop.
-/// Upon resizing, threads are recreated to allow for binding if necessary.
+/// Only the difference is created or destroyed: the other threads keep their
+/// histories and their binding, and the hash is allocated with the first
+/// threads only. Call set(0) first to create all the threads again.
 
 void ThreadPool::set(size_t requested) {
 
-  if (size() > 0)   // destroy any existing thread(s)
-  {
+  if (size() > 0)
       main()->wait_for_search_finished();
 
-      while (size() > 0)
+  if (size() > requested)   // destroy the extra thread(s)
+  {
+      {
+          std::lock_guard<std::mutex> lk(startMutex);
+          for (size_t i = std::max(requested, size_t(1)); i < size(); ++i)
+              (*this)[i]->exit = true;
+      }
+      startCv.notify_all();
+
+      while (size() > requested)
           delete back(), pop_back();
   }
 
-  if (requested > 0)   // create new thread(s)
+  if (size() < requested)   // create new thread(s)
   {
-      push_back(new MainThread(0));
+      size_t first = size();
+
+      if (empty())
+          push_back(new MainThread(engine, 0));
 
       while (size() < requested)
-          push_back(new Thread(size()));
-      clear();
+          push_back(new Thread(engine, size()));
 
-      // Reallocate the hash with the new threadpool size
-      TT.resize(size_t(Options["Hash"]));
+      // The new threads clear their tables in parallel, wait for them
+      for (size_t i = first; i < size(); ++i)
+          (*this)[i]->wait_for_search_finished();
 
-      // Init thread number dependent search params.
-      Search::init();
+      // Allocate the hash, it is cleared by all the threads
+      if (!first && !engine.shares_tt())
+          engine.tt.resize(size_t(engine.options["Hash"]), size());
   }
+
+  // Init thread number dependent search params.
+  if (requested > 0)
+      Search::init(*this);
 }
 
 
@@ -153,8 +253,23 @@ void ThreadPool::set(size_t requested) {
 
 void ThreadPool::clear() {
 
-  for (Thread* th : *this)
-      th->clear();
+  // Each thread clears its own tables, in parallel
+  {
+      std::lock_guard<std::mutex> lk(startMutex);
+      helperJob = [](Thread& th) { th.clear(); };
+      helpersSearching = size() - 1;
+      ++generation;
+  }
+  startCv.notify_all();
+
+  main()->run_custom_job([this]{ main()->clear(); });
+  main()->wait_for_search_finished();
+  wait_for_search_finished();
+
+  {
+      std::lock_guard<std::mutex> lk(startMutex);
+      helperJob = nullptr;
+  }
 
   main()->callsCnt = 0;
   main()->bestPreviousScore = VALUE_INFINITE;
@@ -171,10 +286,12 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
 
   main()->wait_for_search_finished();
 
-  main()->stopOnPonderhit = stop = false;
+  main()->stopOnPonderhit = main()->pvPending = stop = false;
+  main()->nextPvTime = 0;
+  main()->lastInfoTime = now();
   increaseDepth = true;
   main()->ponder = ponderMode;
-  Search::Limits = limits;
+  engine.limits = limits;
   Search::RootMoves rootMoves;
 
   for (const auto& m : MoveList<LEGAL>(pos))
@@ -182,6 +299,20 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
           || std::count(limits.searchmoves.begin(), limits.searchmoves.end(), m))
           rootMoves.emplace_back(m);
 
+  // A move of the book is played at once, see MainThread::search()
+  main()->bookMove = MOVE_NONE;
+
+  if (engine.book.is_open() && !limits.infinite && !limits.mate && !limits.perft)
+  {
+      Move m = engine.book.probe(pos, bool(engine.options["Best Book Move"]));
+
+      if (m && std::count(rootMoves.begin(), rootMoves.end(), m))
+      {
+          main()->bookMove = m;
+          rootMoves = { Search::RootMove(m) };
+      }
+  }
+
   // After ownership transfer 'states' becomes empty, so if we stop the search
   // and call 'go' again without setting a new position states.get() == NULL.
   assert(states.get() || setupStates.get());
@@ -189,20 +320,27 @@ void ThreadPool::start_thinking(Position& pos, StateListPtr& states,
   if (states.get())
       setupStates = std::move(states); // Ownership transfer, states is now empty
 
-  // We use Position::set() to set root position across threads. But there are
-  // some StateInfo fields (previous, pliesFromNull, capturedPiece) that cannot
-  // be deduced from a fen string, so set() clears them and they are set from
-  // setupStates->back() later. The rootState is per thread, earlier states are shared
-  // since they are read-only.
+  // The counters are reset before the search starts, as the main thread may
+  // read them at any time. The helpers copy the root position and moves for
+  // themselves when they start, only the main thread is set up here.
+  bool sharedHistory = bool(engine.options["Shared History"]);
+
   for (Thread* th : *this)
   {
       th->nodes = th->tbHits = th->nmpMinPly = th->bestMoveChanges = 0;
+      th->publish_counters();
       th->rootDepth = th->completedDepth = 0;
-      th->rootMoves = rootMoves;
-      th->rootPos.set(pos, &th->rootState, th);
-      th->rootState = setupStates->back();
+      th->histories = sharedHistory ? &main()->ownHistories : &th->ownHistories;
   }
 
+  for (const auto& rm : rootMoves)
+      rootMoveNodes[from_to(rm.pv[0])] = 0;
+
+  setupPos = &pos;
+  setupRootMoves = rootMoves;
+  main()->rootMoves = std::move(rootMoves);
+  main()->rootPos.set(pos, &main()->rootState, main());
+
   main()->start_searching();
 }
 
@@ -245,23 +383,61 @@ Thread* ThreadPool::get_best_thread() const {
 }
 
 
-/// Start non-main threads
+/// ThreadPool::start_searching() starts the non-main threads with a single
+/// broadcast, instead of waking them up one after another.
 
 void ThreadPool::start_searching() {
 
-    for (Thread* th : *this)
-        if (th != front())
-            th->start_searching();
+  {
+      std::lock_guard<std::mutex> lk(startMutex);
+      helpersSearching = size() - 1;
+      ++generation;
+  }
+
+  startCv.notify_all();
 }
 
 
-/// Wait for non-main threads
+/// ThreadPool::wait_for_search_finished() waits for the non-main threads
 
-void ThreadPool::wait_for_search_finished() const {
+void ThreadPool::wait_for_search_finished() {
 
-    for (Thread* th : *this)
-        if (th != front())
-            th->wait_for_search_finished();
+  std::unique_lock<std::mutex> lk(startMutex);
+  doneCv.wait(lk, [&]{ return helpersSearching == 0; });
+}
+
+
+/// ThreadPool::stop_searching() raises the stop flag and wakes up the main
+/// thread if it is blocked in wait_for_stop(). The flag is set under the
+/// mutex so that the wake up cannot be lost between the check and the wait.
+
+void ThreadPool::stop_searching() {
+
+  std::lock_guard<std::mutex> lk(stopMutex);
+  stop = true;
+  stopCv.notify_one();
+}
+
+
+/// ThreadPool::ponderhit() switches the main thread from pondering to the
+/// normal search, waking it up if it has already finished searching.
+
+void ThreadPool::ponderhit() {
+
+  std::lock_guard<std::mutex> lk(stopMutex);
+  main()->ponder = false;
+  stopCv.notify_one();
+}
+
+
+/// ThreadPool::wait_for_stop() is called by the main thread when its search
+/// is finished. It blocks, without spinning, until the GUI sends "stop" or
+/// "ponderhit" if we are pondering or in an infinite search.
+
+void ThreadPool::wait_for_stop(bool infinite) {
+
+  std::unique_lock<std::mutex> lk(stopMutex);
+  stopCv.wait(lk, [&]{ return stop || !(main()->ponder || infinite); });
 }
 
 } // namespace Stockfish
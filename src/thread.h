@@ -19,12 +19,15 @@
 #ifndef THREAD_H_INCLUDED
 #define THREAD_H_INCLUDED
 
+#include <array>
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "mate.h"
 #include "movepick.h"
 #include "position.h"
 #include "search.h"
@@ -33,6 +36,8 @@
 
 namespace Stockfish {
 
+class Engine;
+
 /// Thread class keeps together all the thread-related stuff. We use
 /// per-thread pawn and material hash tables so that once we get a
 /// pointer to an entry its life time is unlimited and we don't have
@@ -40,26 +45,37 @@ namespace Stockfish {
 
 class Thread {
 
+public:
+  Engine& engine; // Set before starting std::thread, idle_loop() reads its options
+
+private:
+  friend struct ThreadPool;
+
   std::mutex mutex;
   std::condition_variable cv;
   size_t idx;
   bool exit = false, searching = true; // Set before starting std::thread
-  NativeThread stdThread;
+  std::function<void()> jobFunc;
 
 public:
-  explicit Thread(size_t);
+  Thread(Engine&, size_t);
   virtual ~Thread();
   virtual void search();
   void clear();
   void idle_loop();
   void start_searching();
   void wait_for_search_finished();
+  void run_custom_job(std::function<void()> f);
   size_t id() const { return idx; }
 
+  // The memory of the tables of the thread, in bytes
+  static constexpr size_t memory() { return sizeof(Thread) + Material::Table::Bytes; }
+
   Material::Table materialTable;
   size_t pvIdx, pvLast;
   RunningAverage complexityAverage;
-  std::atomic<uint64_t> nodes, tbHits, bestMoveChanges;
+  uint64_t nodes, tbHits; // Only written by the thread, the others read 'published'
+  std::atomic<uint64_t> bestMoveChanges;
   int selDepth, nmpMinPly;
   Color nmpColor;
   Value bestValue, optimism[COLOR_NB];
@@ -69,10 +85,35 @@ public:
   Search::RootMoves rootMoves;
   Depth rootDepth, completedDepth, previousDepth;
   Value rootDelta;
-  CounterMoveHistory counterMoves;
-  ButterflyHistory mainHistory;
-  CapturePieceToHistory captureHistory;
-  ContinuationHistory continuationHistory[2][2];
+  int reductions[MAX_MOVES]; // [depth or moveNumber]
+
+  // The move ordering statistics of the thread. The search goes through
+  // 'histories', which points to those of the main thread instead when the
+  // "Shared History" option is set. The helpers then update the same tables
+  // without any locking, like the transposition table, and a lost or mixed
+  // update only costs a bit of move ordering.
+  struct Histories {
+    CounterMoveHistory counterMoves;
+    ButterflyHistory mainHistory;
+    CapturePieceToHistory captureHistory;
+    ContinuationHistory continuationHistory[2][2];
+  } ownHistories;
+  Histories* histories = &ownHistories;
+
+  // The counters are published every 1024 nodes, and when the search ends,
+  // on a cache line of their own that the other threads can read without
+  // slowing down this one.
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> nodes{0}, tbHits{0};
+  } published;
+
+  void publish_counters() {
+    published.nodes.store(nodes, std::memory_order_relaxed);
+    published.tbHits.store(tbHits, std::memory_order_relaxed);
+  }
+
+private:
+  NativeThread stdThread; // Last, to start once the other members are built
 };
 
 
@@ -85,13 +126,29 @@ struct MainThread : public Thread {
   void search() override;
   void check_time();
 
-  double previousTimeReduction;
-  Value bestPreviousScore;
-  Value bestPreviousAverageScore;
+  double previousTimeReduction = 1.0;
+  Value bestPreviousScore = VALUE_INFINITE;
+  Value bestPreviousAverageScore = VALUE_INFINITE;
   Value iterValue[4];
-  int callsCnt;
+  int callsCnt = 0;
   bool stopOnPonderhit;
+  bool pvPending;      // The last PV update was skipped by the "Info Interval" option
+  TimePoint nextPvTime;
+  TimePoint lastInfoTime; // Of the last debug info, see check_time()
   std::atomic_bool ponder;
+  Move bookMove;
+  Mate::Table mateTable; // Allocated by the first "go mate"
+  PRNG rng = PRNG(uint64_t(now()) | 1); // Non-deterministic, for the skill level
+};
+
+
+/// Breadcrumb marks a node of the first plies as being searched by a thread,
+/// so that the other threads can reduce their search of it and spend their
+/// time elsewhere, see ThreadHolding in search.cpp.
+
+struct Breadcrumb {
+  std::atomic<Thread*> thread;
+  std::atomic<Key> key;
 };
 
 
@@ -101,33 +158,55 @@ struct MainThread : public Thread {
 
 struct ThreadPool : public std::vector<Thread*> {
 
+  explicit ThreadPool(Engine& e) : engine(e) {}
+
   void start_thinking(Position&, StateListPtr&, const Search::LimitsType&, bool = false);
   void clear();
   void set(size_t);
 
   MainThread* main()        const { return static_cast<MainThread*>(front()); }
-  uint64_t nodes_searched() const { return accumulate(&Thread::nodes); }
-  uint64_t tb_hits()        const { return accumulate(&Thread::tbHits); }
+  uint64_t nodes_searched() const { return accumulate(&Thread::Counters::nodes); }
+  uint64_t tb_hits()        const { return accumulate(&Thread::Counters::tbHits); }
+  uint64_t root_move_nodes(Move m) const { return rootMoveNodes[from_to(m)].load(std::memory_order_relaxed); }
   Thread* get_best_thread() const;
   void start_searching();
-  void wait_for_search_finished() const;
+  void wait_for_search_finished();
+  StateListPtr release_states() { return std::move(setupStates); }
+  void stop_searching();
+  void ponderhit();
+  void wait_for_stop(bool infinite);
 
-  std::atomic_bool stop, increaseDepth;
+  std::atomic_bool stop{false}, increaseDepth{true};
+  Engine& engine;
+  std::array<Breadcrumb, 1024> breadcrumbs{};
+  std::array<std::atomic<uint64_t>, SQUARE_NB * SQUARE_NB> rootMoveNodes{}; // By all the threads, by from_to()
 
 private:
+  friend class Thread;
+
   StateListPtr setupStates;
+  std::mutex stopMutex;
+  std::condition_variable stopCv;
 
-  uint64_t accumulate(std::atomic<uint64_t> Thread::* member) const {
+  // The helpers are started together with a single broadcast, and each one
+  // copies the root position and moves for itself.
+  std::mutex startMutex;
+  std::condition_variable startCv, doneCv;
+  uint64_t generation = 0;
+  size_t helpersSearching = 0;
+  std::function<void(Thread&)> helperJob; // Run instead of a search if set
+  const Position* setupPos;
+  Search::RootMoves setupRootMoves;
+
+  uint64_t accumulate(std::atomic<uint64_t> Thread::Counters::* member) const {
 
     uint64_t sum = 0;
     for (Thread* th : *this)
-        sum += (th->*member).load(std::memory_order_relaxed);
+        sum += (th->published.*member).load(std::memory_order_relaxed);
     return sum;
   }
 };
 
-extern ThreadPool Threads;
-
 } // namespace Stockfish
 
 #endif // #ifndef THREAD_H_INCLUDED
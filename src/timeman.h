@@ -22,6 +22,7 @@
 #include "misc.h"
 #include "search.h"
 #include "thread.h"
+#include "uci.h"
 
 namespace Stockfish {
 
@@ -30,22 +31,23 @@ namespace Stockfish {
 
 class TimeManagement {
 public:
-  void init(Search::LimitsType& limits, Color us, int ply);
+  explicit TimeManagement(const ThreadPool& tp) : threads(tp) {}
+  void init(Search::LimitsType& limits, Color us, int ply, UCI::OptionsMap& options);
   TimePoint optimum() const { return optimumTime; }
   TimePoint maximum() const { return maximumTime; }
-  TimePoint elapsed() const { return Search::Limits.npmsec ?
-                                     TimePoint(Threads.nodes_searched()) : now() - startTime; }
+  TimePoint elapsed() const { return useNodesTime ?
+                                     TimePoint(threads.nodes_searched()) : now() - startTime; }
 
-  int64_t availableNodes; // When in 'nodes as time' mode
+  int64_t availableNodes = 0; // When in 'nodes as time' mode
 
 private:
+  const ThreadPool& threads; // The pool whose nodes are counted in 'nodes as time' mode
+  bool useNodesTime = false;
   TimePoint startTime;
   TimePoint optimumTime;
   TimePoint maximumTime;
 };
 
-extern TimeManagement Time;
-
 } // namespace Stockfish
 
 #endif // #ifndef TIMEMAN_H_INCLUDED
@@ -43,7 +43,7 @@ struct TTEntry {
   Depth depth() const { return (Depth)depth8 + DEPTH_OFFSET; }
   bool is_pv()  const { return (bool)(genBound8 & 0x4); }
   Bound bound() const { return (Bound)(genBound8 & 0x3); }
-  void save(Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev);
+  void save(Key k, Value v, bool pv, Bound b, Depth d, Move m, Value ev, uint8_t generation8);
 
 private:
   friend class TranspositionTable;
@@ -83,10 +83,11 @@ class TranspositionTable {
 public:
  ~TranspositionTable() { aligned_large_pages_free(table); }
   void new_search() { generation8 += GENERATION_DELTA; } // Lower bits are used for other things
+  uint8_t generation() const { return generation8; }
   TTEntry* probe(const Key key, bool& found) const;
   int hashfull() const;
-  void resize(size_t mbSize);
-  void clear();
+  void resize(size_t mbSize, size_t threadCount);
+  void clear(size_t threadCount);
 
   TTEntry* first_entry(const Key key) const {
     return &table[mul_hi64(key, clusterCount)].entry[0];
@@ -95,13 +96,11 @@ public:
 private:
   friend struct TTEntry;
 
-  size_t clusterCount;
-  Cluster* table;
-  uint8_t generation8; // Size must be not bigger than TTEntry::genBound8
+  size_t clusterCount = 0;
+  Cluster* table = nullptr;
+  uint8_t generation8 = 0; // Size must be not bigger than TTEntry::genBound8
 };
 
-extern TranspositionTable TT;
-
 } // namespace Stockfish
 
 #endif // #ifndef TT_H_INCLUDED
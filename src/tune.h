@@ -24,6 +24,8 @@
 #include <type_traits>
 #include <vector>
 
+#include "uci.h"
+
 namespace Stockfish {
 
 typedef std::pair<int, int> Range; // Option's min-max values
@@ -145,9 +147,10 @@ public:
   static int add(const std::string& names, Args&&... args) {
     return instance().add(SetDefaultRange, names.substr(1, names.size() - 2), args...); // Remove trailing parenthesis
   }
-  static void init() { for (auto& e : instance().list) e->init_option(); read_options(); } // Deferred, due to UCI::Options access
+  static void init(UCI::OptionsMap& o) { options = &o; for (auto& e : instance().list) e->init_option(); read_options(); } // Deferred, due to UCI::Options access
   static void read_options() { for (auto& e : instance().list) e->read_option(); }
   static bool update_on_last;
+  static UCI::OptionsMap* options; // Of the engine of the UCI program
 };
 
 // Some macro magic :-) we define a dummy int variable that compiler initializes calling Tune::add()
@@ -35,6 +35,9 @@
 ///
 /// -DUSE_PEXT    | Add runtime support for use of pext asm-instruction. Works
 ///               | only in 64-bit mode and requires hardware with pext support.
+///
+/// -DUSE_NUMA    | Add the "NUMA Replication" option, which binds the threads to
+///               | NUMA nodes and gives each node its own copy of the lookup tables.
 
 #include <cassert>
 #include <cctype>
@@ -188,17 +191,17 @@ struct Bitboard {
         return !(*this == y);
     }
 
-    inline Bitboard& operator |=(const Bitboard x) {
+    constexpr Bitboard& operator |=(const Bitboard x) {
         b64[0] |= x.b64[0];
         b64[1] |= x.b64[1];
         return *this;
     }
-    inline Bitboard& operator &=(const Bitboard x) {
+    constexpr Bitboard& operator &=(const Bitboard x) {
         b64[0] &= x.b64[0];
         b64[1] &= x.b64[1];
         return *this;
     }
-    inline Bitboard& operator ^=(const Bitboard x) {
+    constexpr Bitboard& operator ^=(const Bitboard x) {
         b64[0] ^= x.b64[0];
         b64[1] ^= x.b64[1];
         return *this;
@@ -228,6 +231,10 @@ struct Bitboard {
         return Bitboard(b64[0] - x.b64[0] - (b64[1] < x.b64[1]), b64[1] - x.b64[1]);
     }
 
+    constexpr Bitboard operator + (const Bitboard x) const {
+        return Bitboard(b64[0] + x.b64[0] + (b64[1] + x.b64[1] < b64[1]), b64[1] + x.b64[1]);
+    }
+
     constexpr Bitboard operator - (const int x) const {
         return *this - Bitboard(x);
     }
@@ -407,8 +414,8 @@ inline T& operator+=(T& d1, int d2) { return d1 = d1 + d2; }       \
 inline T& operator-=(T& d1, int d2) { return d1 = d1 - d2; }
 
 #define ENABLE_INCR_OPERATORS_ON(T)                                \
-inline T& operator++(T& d) { return d = T(int(d) + 1); }           \
-inline T& operator--(T& d) { return d = T(int(d) - 1); }
+constexpr T& operator++(T& d) { return d = T(int(d) + 1); }        \
+constexpr T& operator--(T& d) { return d = T(int(d) - 1); }
 
 #define ENABLE_FULL_OPERATORS_ON(T)                                \
 ENABLE_BASE_OPERATORS_ON(T)                                        \
@@ -437,8 +444,8 @@ ENABLE_BASE_OPERATORS_ON(Score)
 /// Additional operators to add a Direction to a Square
 constexpr Square operator+(Square s, Direction d) { return Square(int(s) + int(d)); }
 constexpr Square operator-(Square s, Direction d) { return Square(int(s) - int(d)); }
-inline Square& operator+=(Square& s, Direction d) { return s = s + d; }
-inline Square& operator-=(Square& s, Direction d) { return s = s - d; }
+constexpr Square& operator+=(Square& s, Direction d) { return s = s + d; }
+constexpr Square& operator-=(Square& s, Direction d) { return s = s - d; }
 inline Square operator^(Square s, Square i) { return Square(int(s) ^ int(i)); }
 
 /// Only declared but not defined. We don't want to multiply two scores due to
@@ -537,7 +544,7 @@ constexpr Square to_sq(Move m) {
 }
 
 constexpr int from_to(Move m) {
-  return m;
+  return from_sq(m) * SQUARE_NB + to_sq(m);
 }
 
 constexpr Move make_move(Square from, Square to) {
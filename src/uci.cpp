@@ -22,13 +22,12 @@
 #include <sstream>
 #include <string>
 
+#include "engine.h"
 #include "evaluate.h"
 #include "movegen.h"
 #include "position.h"
 #include "search.h"
 #include "thread.h"
-#include "timeman.h"
-#include "tt.h"
 #include "uci.h"
 
 using namespace std;
@@ -36,22 +35,24 @@ using namespace std;
 namespace Stockfish {
 
 extern vector<string> setup_bench(const Position&, istream&);
+extern void analyse(Engine& engine, istream& args);
+extern void selfplay(Engine& engine, istream& args);
+extern void datagen(Engine& engine, istream& args);
+extern void texel(Engine& engine, istream& args);
+extern void tbgen(Engine& engine, istream& args);
+extern void makebook(Engine& engine, istream& args);
 
 namespace {
 
-  // FEN string for the initial position in standard xiangqi
-  const char* StartFEN = "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR w";
-
-
   // position() is called when the engine receives the "position" UCI command.
   // It sets up the position that is described in the given FEN string ("fen") or
   // the initial position ("startpos") and then makes the moves given in the following
   // move list ("moves").
 
-  void position(Position& pos, istringstream& is, StateListPtr& states) {
+  void position(Engine& engine, istringstream& is) {
 
-    Move m;
     string token, fen;
+    vector<string> moves;
 
     is >> token;
 
@@ -66,25 +67,21 @@ namespace {
     else
         return;
 
-    states = StateListPtr(new std::deque<StateInfo>(1)); // Drop the old state and create a new one
-    pos.set(fen, &states->back(), Threads.main());
-
     // Parse the move list, if any
-    while (is >> token && (m = UCI::to_move(pos, token)) != MOVE_NONE)
-    {
-        states->emplace_back();
-        pos.do_move(m, states->back());
-    }
+    while (is >> token)
+        moves.push_back(token);
+
+    engine.set_position(fen, moves);
   }
 
   // trace_eval() prints the evaluation of the current position, consistent with
   // the UCI options set so far.
 
-  void trace_eval(Position& pos) {
+  void trace_eval(Engine& engine) {
 
     StateListPtr states(new std::deque<StateInfo>(1));
     Position p;
-    p.set(pos.fen(), &states->back(), Threads.main());
+    p.set(engine.position().fen(), &states->back(), engine.threads.main());
 
     sync_cout << "\n" << Eval::trace(p) << sync_endl;
   }
@@ -92,7 +89,7 @@ namespace {
   // setoption() is called when the engine receives the "setoption" UCI command.
   // The function updates the UCI option ("name") to the given value ("value").
 
-  void setoption(istringstream& is) {
+  void setoption(Engine& engine, istringstream& is) {
 
     string token, name, value;
 
@@ -106,9 +103,7 @@ namespace {
     while (is >> token)
         value += (value.empty() ? "" : " ") + token;
 
-    if (Options.count(name))
-        Options[name] = value;
-    else
+    if (!engine.set_option(name, value))
         sync_cout << "No such option: " << name << sync_endl;
   }
 
@@ -117,8 +112,9 @@ namespace {
   // sets the thinking time and other parameters from the input string, then starts
   // with a search.
 
-  void go(Position& pos, istringstream& is, StateListPtr& states) {
+  void go(Engine& engine, istringstream& is) {
 
+    const Position& pos = engine.position();
     Search::LimitsType limits;
     string token;
     bool ponderMode = false;
@@ -143,7 +139,7 @@ namespace {
         else if (token == "infinite")  limits.infinite = 1;
         else if (token == "ponder")    ponderMode = true;
 
-    Threads.start_thinking(pos, states, limits, ponderMode);
+    engine.go(limits, ponderMode);
   }
 
 
@@ -151,12 +147,12 @@ namespace {
   // Firstly, a list of UCI commands is set up according to the bench
   // parameters, then it is run one by one, printing a summary at the end.
 
-  void bench(Position& pos, istream& args, StateListPtr& states) {
+  void bench(Engine& engine, istream& args) {
 
     string token;
     uint64_t num, nodes = 0, cnt = 1;
 
-    vector<string> list = setup_bench(pos, args);
+    vector<string> list = setup_bench(engine.position(), args);
     num = count_if(list.begin(), list.end(), [](string s) { return s.find("go ") == 0 || s.find("eval") == 0; });
 
     TimePoint elapsed = now();
@@ -168,19 +164,19 @@ namespace {
 
         if (token == "go" || token == "eval")
         {
-            cerr << "\nPosition: " << cnt++ << '/' << num << " (" << pos.fen() << ")" << endl;
+            cerr << "\nPosition: " << cnt++ << '/' << num << " (" << engine.position().fen() << ")" << endl;
             if (token == "go")
             {
-               go(pos, is, states);
-               Threads.main()->wait_for_search_finished();
-               nodes += Threads.nodes_searched();
+               go(engine, is);
+               engine.wait_for_search_finished();
+               nodes += engine.threads.nodes_searched();
             }
             else
-                trace_eval(pos);
+                trace_eval(engine);
         }
-        else if (token == "setoption")  setoption(is);
-        else if (token == "position")   position(pos, is, states);
-        else if (token == "ucinewgame") { Search::clear(); elapsed = now(); } // Search::clear() may take a while
+        else if (token == "setoption")  setoption(engine, is);
+        else if (token == "position")   position(engine, is);
+        else if (token == "ucinewgame") { engine.clear(); elapsed = now(); } // Engine::clear() may take a while
     }
 
     elapsed = now() - elapsed + 1; // Ensure positivity to avoid a 'divide by zero'
@@ -202,13 +198,9 @@ namespace {
 /// like running 'bench', the function returns immediately after the command is executed.
 /// In addition to the UCI ones, some additional debug commands are also supported.
 
-void UCI::loop(int argc, char* argv[]) {
+void UCI::loop(Engine& engine, int argc, char* argv[]) {
 
-  Position pos;
   string token, cmd;
-  StateListPtr states(new std::deque<StateInfo>(1));
-
-  pos.set(StartFEN, &states->back(), Threads.main());
 
   for (int i = 1; i < argc; ++i)
       cmd += std::string(argv[i]) + " ";
@@ -224,33 +216,39 @@ void UCI::loop(int argc, char* argv[]) {
 
       if (    token == "quit"
           ||  token == "stop")
-          Threads.stop = true;
+          engine.stop();
 
       // The GUI sends 'ponderhit' to tell that the user has played the expected move.
       // So, 'ponderhit' is sent if pondering was done on the same move that the user
       // has played. The search should continue, but should also switch from pondering
       // to the normal search.
       else if (token == "ponderhit")
-          Threads.main()->ponder = false; // Switch to the normal search
+          engine.ponderhit(); // Switch to the normal search
 
       else if (token == "uci")
           sync_cout << "id name " << engine_info(true)
-                    << "\n"       << Options
+                    << "\n"       << engine.options
                     << "\nuciok"  << sync_endl;
 
-      else if (token == "setoption")  setoption(is);
-      else if (token == "go")         go(pos, is, states);
-      else if (token == "position")   position(pos, is, states);
-      else if (token == "fen" || token == "startpos") is.seekg(0), position(pos, is, states);
-      else if (token == "ucinewgame") Search::clear();
+      else if (token == "setoption")  setoption(engine, is);
+      else if (token == "go")         go(engine, is);
+      else if (token == "position")   position(engine, is);
+      else if (token == "fen" || token == "startpos") is.seekg(0), position(engine, is);
+      else if (token == "ucinewgame") engine.clear();
       else if (token == "isready")    sync_cout << "readyok" << sync_endl;
 
       // Add custom non-UCI commands, mainly for debugging purposes.
       // These commands must not be used during a search!
-      else if (token == "flip")     pos.flip();
-      else if (token == "bench")    bench(pos, is, states);
-      else if (token == "d")        sync_cout << pos << sync_endl;
-      else if (token == "eval")     trace_eval(pos);
+      else if (token == "flip")     engine.flip();
+      else if (token == "bench")    bench(engine, is);
+      else if (token == "analyse")  analyse(engine, is);
+      else if (token == "selfplay") selfplay(engine, is);
+      else if (token == "datagen")  datagen(engine, is);
+      else if (token == "texel")    texel(engine, is);
+      else if (token == "tbgen")    tbgen(engine, is);
+      else if (token == "makebook") makebook(engine, is);
+      else if (token == "d")        sync_cout << engine.position() << sync_endl;
+      else if (token == "eval")     trace_eval(engine);
       else if (token == "compiler") sync_cout << compiler_info() << sync_endl;
       else if (token == "--help" || token == "help" || token == "--license" || token == "license")
           sync_cout << "\nPikafish is a powerful xiangqi engine for playing and analyzing."
@@ -326,18 +324,21 @@ string UCI::move(Move m) {
 
 
 /// UCI::to_move() converts a string representing a move in coordinate notation
-/// (g1f3, a7a8q) to the corresponding legal Move, if any.
+/// (h2e2) to the corresponding legal Move, if any. The squares are parsed
+/// directly and the move is checked like a hash move, instead of generating
+/// all the legal moves, as GUIs send the whole game before every search.
 
 Move UCI::to_move(const Position& pos, string& str) {
 
-  if (str.length() == 5)
-      str[4] = char(tolower(str[4])); // The promotion piece character must be lowercased
+  if (   str.length() != 4
+      || str[0] < 'a' || str[0] > 'i' || str[1] < '0' || str[1] > '9'
+      || str[2] < 'a' || str[2] > 'i' || str[3] < '0' || str[3] > '9')
+      return MOVE_NONE;
 
-  for (const auto& m : MoveList<LEGAL>(pos))
-      if (str == UCI::move(m))
-          return m;
+  Move m = make_move(make_square(File(str[0] - 'a'), Rank(str[1] - '0')),
+                     make_square(File(str[2] - 'a'), Rank(str[3] - '0')));
 
-  return MOVE_NONE;
+  return pos.pseudo_legal(m) && pos.legal(m) ? m : MOVE_NONE;
 }
 
 } // namespace Stockfish
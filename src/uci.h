@@ -19,6 +19,7 @@
 #ifndef UCI_H_INCLUDED
 #define UCI_H_INCLUDED
 
+#include <functional>
 #include <map>
 #include <string>
 
@@ -26,6 +27,7 @@
 
 namespace Stockfish {
 
+class Engine;
 class Position;
 
 namespace UCI {
@@ -43,7 +45,7 @@ typedef std::map<std::string, Option, CaseInsensitiveLess> OptionsMap;
 /// The Option class implements each option as specified by the UCI protocol
 class Option {
 
-  typedef void (*OnChange)(const Option&);
+  typedef std::function<void(const Option&)> OnChange;
 
 public:
   Option(OnChange = nullptr);
@@ -67,8 +69,8 @@ private:
   OnChange on_change;
 };
 
-void init(OptionsMap&);
-void loop(int argc, char* argv[]);
+void init(OptionsMap&, Engine&);
+void loop(Engine& engine, int argc, char* argv[]);
 int pawn_eval(Value v);
 std::string value(Value v);
 std::string square(Square s);
@@ -78,7 +80,6 @@ Move to_move(const Position& pos, std::string& str);
 
 } // namespace UCI
 
-extern UCI::OptionsMap Options;
 extern bool EnableRule60;
 extern bool StrictThreeFold;
 extern bool ChaseWithCheck;
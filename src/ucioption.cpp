@@ -17,22 +17,24 @@
 */
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <ostream>
 #include <sstream>
 
+#include <vector>
+
+#include "engine.h"
 #include "evaluate.h"
 #include "misc.h"
-#include "search.h"
-#include "thread.h"
-#include "tt.h"
+#include "numa.h"
 #include "uci.h"
 
 using std::string;
 
 namespace Stockfish {
 
-UCI::OptionsMap Options; // Global object
+// The rule options are process wide, they are shared by all the engines
 bool EnableRule60 = true;
 bool StrictThreeFold = false;
 bool ChaseWithCheck = true;
@@ -41,10 +43,7 @@ bool FullEvaluation = true;
 namespace UCI {
 
 /// 'On change' actions, triggered by an option's value change
-void on_clear_hash(const Option&) { Search::clear(); }
-void on_hash_size(const Option& o) { TT.resize(size_t(o)); }
 void on_logger(const Option& o) { start_logger(o); }
-void on_threads(const Option& o) { Threads.set(size_t(o)); }
 static void on_rule60(const Option& o) { EnableRule60 = bool(o); }
 static void on_strict_three_fold(const Option& o) { StrictThreeFold = bool(o); }
 static void on_chase_with_check(const Option& o) { ChaseWithCheck = bool(o); }
@@ -58,12 +57,20 @@ bool CaseInsensitiveLess::operator() (const string& s1, const string& s2) const
 }
 
 
-/// UCI::init() initializes the UCI options to their hard-coded default values
+/// UCI::init() initializes the UCI options of an engine to their hard-coded
+/// default values. The actions of the engine specific options are bound to it.
 
-void init(OptionsMap& o) {
+void init(OptionsMap& o, Engine& engine) {
 
   constexpr int MaxHashMB = Is64Bit ? 33554432 : 2048;
 
+  auto on_clear_hash = [&engine](const Option&) { engine.clear(); };
+  auto on_hash_size  = [&engine](const Option& opt) { engine.resize_hash(size_t(opt)); };
+  auto on_threads    = [&engine](const Option& opt) { engine.resize_threads(size_t(opt)); };
+  auto on_eval_file  = [&engine](const Option& opt) { engine.load_eval(std::string(opt)); };
+  auto on_bitbases   = [&engine](const Option& opt) { engine.load_bitbases(std::string(opt)); };
+  auto on_book       = [&engine](const Option& opt) { engine.load_book(std::string(opt)); };
+
   o["Debug Log File"]        << Option("", on_logger);
   o["Threads"]               << Option(1, 1, 1024, on_threads);
   o["Hash"]                  << Option(16, 1, MaxHashMB, on_hash_size);
@@ -74,12 +81,27 @@ void init(OptionsMap& o) {
   o["Move Overhead"]         << Option(10, 0, 5000);
   o["Slow Mover"]            << Option(100, 10, 1000);
   o["nodestime"]             << Option(0, 0, 10000);
+  o["Info Interval"]         << Option(0, 0, 10000);
+  o["Shared History"]        << Option(false);
+  o["Helper Diversity"]      << Option("None var None var Depth var Window var Both", "None");
+  o["Mate Solver"]           << Option(true);
   o["Sixty Move Rule"]       << Option(true, on_rule60);
   o["Strict Three Fold"]     << Option(false, on_strict_three_fold);
   o["Chase With Check"]      << Option(true, on_chase_with_check);
   o["Full Evaluation"]      << Option(true, on_full_evaluation);
+  o["EvalFile"]              << Option("<internal>", on_eval_file);
+  o["BitbasePath"]           << Option("<empty>", on_bitbases);
+  o["Book"]                  << Option("<empty>", on_book);
+  o["Best Book Move"]        << Option(false);
   o["UCI_LimitStrength"]     << Option(false);
   o["UCI_Elo"]               << Option(1350, 1350, 2850);
+#if defined(USE_NUMA)
+  o["NUMA Replication"]      << Option(false, [&engine](const Option& opt) {
+                                    engine.resize_threads(0); // Bind all the threads again
+                                    if (!bool(opt))
+                                        Numa::free_replicas();
+                                    engine.resize_threads(size_t(engine.options["Threads"])); });
+#endif
 }
 
 
@@ -88,23 +110,27 @@ void init(OptionsMap& o) {
 
 std::ostream& operator<<(std::ostream& os, const OptionsMap& om) {
 
-  for (size_t idx = 0; idx < om.size(); ++idx)
-      for (const auto& it : om)
-          if (it.second.idx == idx)
-          {
-              const Option& o = it.second;
-              os << "\noption name " << it.first << " type " << o.type;
+  // The insertion counter is shared by all the maps, so sort rather than
+  // expecting the indices of this map to be 0 .. size() - 1.
+  std::vector<const OptionsMap::value_type*> sorted;
+  for (const auto& it : om)
+      sorted.push_back(&it);
 
-              if (o.type == "string" || o.type == "check" || o.type == "combo")
-                  os << " default " << o.defaultValue;
+  std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return a->second.idx < b->second.idx; });
 
-              if (o.type == "spin")
-                  os << " default " << int(stof(o.defaultValue))
-                     << " min "     << o.min
-                     << " max "     << o.max;
+  for (const auto* it : sorted)
+  {
+      const Option& o = it->second;
+      os << "\noption name " << it->first << " type " << o.type;
 
-              break;
-          }
+      if (o.type == "string" || o.type == "check" || o.type == "combo")
+          os << " default " << o.defaultValue;
+
+      if (o.type == "spin")
+          os << " default " << int(stof(o.defaultValue))
+             << " min "     << o.min
+             << " max "     << o.max;
+  }
 
   return os;
 }
@@ -148,7 +174,7 @@ bool Option::operator==(const char* s) const {
 
 void Option::operator<<(const Option& o) {
 
-  static size_t insert_order = 0;
+  static std::atomic<size_t> insert_order = 0; // Engines may be created concurrently
 
   *this = o;
   idx = insert_order++;